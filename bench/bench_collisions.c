@@ -0,0 +1,92 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "physics.h"
+
+// collision checks with many long snakes: every tick each snake moves one cell and its head is
+// looked up in the occupancy grid, compared with scanning every segment of every snake
+// (what the checks cost before the grid); reports time per tick for both
+
+#define BENCH_DEFAULT_SNAKES 128
+#define BENCH_SNAKE_LENGTH 1000
+#define BENCH_TICKS 150
+#define BENCH_WIDTH (BENCH_SNAKE_LENGTH + BENCH_TICKS + 50)
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// head against every segment of every snake, own body without the head
+static bool scan_collision(const Player *players, const size_t count, const Player *p) {
+    const Position head = *snake_at(&p->snake, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const Snake *s = &players[i].snake;
+        for (size_t k = &players[i] == p ? 1 : 0; k < s->length; ++k) {
+            const Position *q = snake_at(s, k);
+            if (q->x == head.x && q->y == head.y) return true;
+        }
+    }
+    return false;
+}
+
+// usage: bench-collisions [snakes]
+int main(const int argc, char *argv[]) {
+    const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_SNAKES;
+    const int height = (int)(2 * count + 2);
+
+    Grid grid;
+    if (grid_init(&grid, BENCH_WIDTH, height) < 0) {
+        fprintf(stderr, "failed to allocate %dx%d grid\n", BENCH_WIDTH, height);
+        return 1;
+    }
+    BodyPool bodies;
+    body_pool_init(&bodies);
+    Player *players = calloc(count, sizeof(Player));
+    if (!players) return 1;
+
+    // one snake per odd row, facing right with room to move for every tick
+    for (size_t i = 0; i < count; ++i) {
+        Snake *s = &players[i].snake;
+        if (snake_init(s, BENCH_SNAKE_LENGTH, &bodies) < 0) return 1;
+        s->direction = s->next_direction = DIR_RIGHT;
+        for (size_t k = 0; k < BENCH_SNAKE_LENGTH; ++k) {
+            *snake_at(s, k) = (Position){ BENCH_SNAKE_LENGTH - (int)k, 2 * (int)i + 1 };
+            grid_snake_enter(&grid, *snake_at(s, k));
+        }
+    }
+
+    size_t hits = 0;
+    double grid_s = 0, scan_s = 0;
+    for (int t = 0; t < BENCH_TICKS; ++t) {
+        double t0 = now_s();
+        for (size_t i = 0; i < count; ++i) {
+            Player *p = &players[i];
+            move_player(p, &grid);
+            hits += player_player_collision(p, &grid) || player_obstacle_collision(p, &grid) ||
+                    player_fruit_collision(p, &grid) >= 0 || player_wall_collision(p, BENCH_WIDTH, height);
+        }
+        grid_s += now_s() - t0;
+
+        t0 = now_s();
+        for (size_t i = 0; i < count; ++i) {
+            hits += scan_collision(players, count, &players[i]);
+        }
+        scan_s += now_s() - t0;
+    }
+
+    printf("%zu snakes of length %d, %d ticks\n", count, BENCH_SNAKE_LENGTH, BENCH_TICKS);
+    printf("grid lookups (move + checks): %10.1f us/tick\n", grid_s / BENCH_TICKS * 1e6);
+    printf("segment scan (checks only):   %10.1f us/tick\n", scan_s / BENCH_TICKS * 1e6);
+    printf("collisions: %zu (expected 0)\n", hits);
+
+    for (size_t i = 0; i < count; ++i) {
+        snake_destroy(&players[i].snake, &bodies);
+    }
+    free(players);
+    body_pool_destroy(&bodies);
+    grid_destroy(&grid);
+    return hits == 0 ? 0 : 1;
+}
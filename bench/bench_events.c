@@ -0,0 +1,106 @@
+#define _POSIX_C_SOURCE 199309L
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "events.h"
+
+// event ring under contention: 1..64 producer threads push tagged events while
+// the consumer drains in batches like the tick thread does; reports events/sec
+// and checks that every producer's events arrive complete and in order
+
+#define BENCH_MAX_PRODUCERS 64
+#define BENCH_DEFAULT_EVENTS 200000 // per producer
+
+typedef struct {
+    EventQueue *q;
+    uint32_t id;
+    size_t events;
+    _Atomic bool *start;
+} Producer;
+
+static EventQueue queue; // large ring, kept off the stack
+static Event batch[MAX_EVENTS];
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void *producer_thread(void *arg) {
+    const Producer *p = arg;
+    while (!atomic_load_explicit(p->start, memory_order_acquire)) {
+        sched_yield(); // all producers start together
+    }
+    for (size_t i = 0; i < p->events; ++i) {
+        const Event ev = { .type = EV_INPUT, .u.input = { .player = { .slot = p->id, .gen = (uint32_t)i } } };
+        enqueue_event(p->q, ev);
+    }
+    return NULL;
+}
+
+/**
+ * Runs one round with the given number of producers.
+ *
+ * @param producers  Number of producer threads.
+ * @param events     Events pushed by each producer.
+ * @return 0 if every event arrived once and in per-producer order, -1 otherwise.
+ */
+static int bench_round(const size_t producers, const size_t events) {
+    Producer args[BENCH_MAX_PRODUCERS];
+    pthread_t threads[BENCH_MAX_PRODUCERS];
+    uint32_t next[BENCH_MAX_PRODUCERS] = {0}; // expected sequence per producer
+    _Atomic bool start = false;
+
+    event_queue_init(&queue);
+    for (size_t i = 0; i < producers; ++i) {
+        args[i] = (Producer){ .q = &queue, .id = (uint32_t)i, .events = events, .start = &start };
+        if (pthread_create(&threads[i], NULL, producer_thread, &args[i]) != 0) {
+            fprintf(stderr, "failed to start producer %zu\n", i);
+            exit(1);
+        }
+    }
+
+    const size_t total = producers * events;
+    size_t received = 0;
+    int rc = 0;
+
+    const double t0 = now_s();
+    atomic_store_explicit(&start, true, memory_order_release);
+    while (received < total) {
+        const size_t n = drain_events(&queue, batch, MAX_EVENTS);
+        for (size_t i = 0; i < n; ++i) {
+            const PlayerHandle h = batch[i].u.input.player;
+            if (h.slot >= producers || h.gen != next[h.slot]) rc = -1;
+            else next[h.slot]++;
+        }
+        received += n;
+    }
+    const double elapsed = now_s() - t0;
+
+    for (size_t i = 0; i < producers; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    const BatchStats *s = &queue.stats;
+    printf("%3zu producers  %10.0f events/s  avg batch %7.1f  max batch %4zu  %s\n",
+           producers, (double)total / elapsed,
+           s->batches > 0 ? (double)s->items / (double)s->batches : 0.0, s->max_batch,
+           rc == 0 ? "ok" : "ORDER BROKEN");
+    event_queue_destroy(&queue);
+    return rc;
+}
+
+// usage: bench-events [events_per_producer]
+int main(const int argc, char *argv[]) {
+    const size_t events = argc > 1 ? strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_EVENTS;
+
+    int rc = 0;
+    for (size_t producers = 1; producers <= BENCH_MAX_PRODUCERS; producers *= 2) {
+        if (bench_round(producers, events) < 0) rc = 1;
+    }
+    return rc;
+}
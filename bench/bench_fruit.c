@@ -0,0 +1,101 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "grid.h"
+
+// fruit placement on a filling board: inner cells are covered by snake segments in random
+// order up to each occupancy level, then free cells are picked from the free-cell set and,
+// for comparison, by rejection sampling random cells (what fruit spawning did before the set)
+// every pick is checked to be free, and a full board must report that nothing is free
+
+#define BENCH_SIZE 256
+#define BENCH_PICKS 1000000
+#define BENCH_REJECT_LIMIT 100000000 // tries before rejection sampling gives up
+
+static const double levels[] = { 0.5, 0.9, 0.95, 0.99, 0.999 };
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool cell_free(const Grid *g, const Position p) {
+    const GridCell *c = grid_cell(g, p);
+    return c->snakes == 0 && c->fruit_ref == 0 && !grid_obstacle_at(g, p);
+}
+
+// random inner cells until a free one turns up, false if it took too long
+static bool reject_free(const Grid *g, Position *out, size_t *tries) {
+    while (*tries < BENCH_REJECT_LIMIT) {
+        (*tries)++;
+        const Position p = { 1 + rand() % (g->width - 2), 1 + rand() % (g->height - 2) };
+        if (cell_free(g, p)) {
+            *out = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+// usage: bench-fruit [picks]
+int main(const int argc, char *argv[]) {
+    const size_t picks = argc > 1 ? strtoul(argv[1], NULL, 10) : BENCH_PICKS;
+
+    Grid grid;
+    if (grid_init(&grid, BENCH_SIZE, BENCH_SIZE) < 0) {
+        fprintf(stderr, "failed to allocate grid\n");
+        return 1;
+    }
+
+    // inner cells in random order, covered front to back
+    const size_t inner = (size_t)(BENCH_SIZE - 2) * (BENCH_SIZE - 2);
+    Position *order = malloc(inner * sizeof(Position));
+    if (!order) return 1;
+    for (size_t i = 0; i < inner; ++i) {
+        order[i] = (Position){ 1 + (int)(i % (BENCH_SIZE - 2)), 1 + (int)(i / (BENCH_SIZE - 2)) };
+    }
+    srand(1);
+    for (size_t i = inner - 1; i > 0; --i) {
+        const size_t j = (size_t)rand() % (i + 1);
+        const Position t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    int rc = 0;
+    size_t covered = 0;
+    printf("%dx%d board, %zu picks per level\n", BENCH_SIZE, BENCH_SIZE, picks);
+    for (size_t l = 0; l < sizeof levels / sizeof levels[0]; ++l) {
+        const size_t target = (size_t)(levels[l] * (double)inner);
+        while (covered < target) grid_snake_enter(&grid, order[covered++]);
+
+        Position p;
+        double t0 = now_s();
+        for (size_t i = 0; i < picks; ++i) {
+            if (!grid_random_free(&grid, &p) || !cell_free(&grid, p)) rc = 1;
+        }
+        const double set_s = now_s() - t0;
+
+        size_t tries = 0, found = 0;
+        t0 = now_s();
+        for (size_t i = 0; i < picks && reject_free(&grid, &p, &tries); ++i) found++;
+        const double reject_s = now_s() - t0;
+
+        printf("%6.1f%% occupied  free set %8.1f ns/pick  rejection %10.1f ns/pick (%.0f tries)%s\n",
+               100.0 * (double)covered / (double)inner, set_s / (double)picks * 1e9,
+               found > 0 ? reject_s / (double)found * 1e9 : 0.0,
+               found > 0 ? (double)tries / (double)found : 0.0, rc == 0 ? "" : "  NOT FREE");
+    }
+
+    while (covered < inner) grid_snake_enter(&grid, order[covered++]);
+    Position p;
+    const bool full_ok = !grid_random_free(&grid, &p);
+    printf("full board: %s\n", full_ok ? "no free cell reported" : "PICKED A CELL");
+    if (!full_ok) rc = 1;
+
+    free(order);
+    grid_destroy(&grid);
+    return rc;
+}
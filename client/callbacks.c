@@ -22,10 +22,10 @@ void btn_exit_to_main_menu(void *ctx_ptr) {
 
 
     if (ctx->socket_fd >= 0) {
-        log_client("sending leave message to server\n");
-        if (send_leave(ctx->socket_fd) < 0) {
-            log_client("FAILED: to send leave\n");
-        } else log_client("send\n");
+        log_client("queueing leave message to server\n");
+        if (!enqueue_command(ctx->out, (Command){ .type = CMD_LEAVE, .socket_fd = ctx->socket_fd })) {
+            log_client("FAILED: to queue leave\n");
+        }
 
         disconnect_from_server(ctx);
     }
@@ -61,10 +61,10 @@ void btn_resume_game(void *ctx_ptr) {
     ClientContext *ctx = ctx_ptr;
     menu_pop(&ctx->menus);
 
-    log_client("sending resume message to server\n");
-    if (send_resume(ctx->socket_fd) < 0) {
-        log_client("FAILED: to send resume\n");
-    } else log_client("send\n");
+    log_client("queueing resume message to server\n");
+    if (!enqueue_command(ctx->out, (Command){ .type = CMD_RESUME, .socket_fd = ctx->socket_fd })) {
+        log_client("FAILED: to queue resume\n");
+    }
 
     ctx->mode = CLIENT_PLAYING;
 }
@@ -149,11 +149,11 @@ void btn_load_from_file(void *ctx_ptr) {
 void btn_cancel_awaiting(void *ctx_ptr) {
     ClientContext *ctx = ctx_ptr;
 
-    // send leave must precede disconnect
-    log_client("send leave message to server\n");
-    if (send_leave(ctx->socket_fd) < 0) {
-        log_client("FAILED: to send leave\n");
-    } else log_client("send\n");
+    // leave must be queued before disconnect (sender closes socket after flushing it)
+    log_client("queueing leave message to server\n");
+    if (!enqueue_command(ctx->out, (Command){ .type = CMD_LEAVE, .socket_fd = ctx->socket_fd })) {
+        log_client("FAILED: to queue leave\n");
+    }
 
     disconnect_from_server(ctx);
 
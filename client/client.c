@@ -15,67 +15,145 @@
 #include "logging.h"
 #include "context.h"
 
+/**
+ * Sends the oldest buffered direction change once a tick has passed since the last one.
+ *
+ * The server applies one direction per tick, so turns pressed faster than
+ * that would overwrite each other; spacing them by the game's tick rate
+ * lets each take effect. Turns left over outside of play are dropped.
+ *
+ * @param ctx  Client context.
+ * @param now  Current CLOCK_MONOTONIC time.
+ */
+static void send_paced_turn(ClientContext *ctx, const struct timespec *now) {
+    if (ctx->mode != CLIENT_PLAYING) ctx->turn_count = 0;
+    if (ctx->turn_count == 0 || timespec_before(now, &ctx->next_turn_at)) return;
+
+    if (!enqueue_command(ctx->out, (Command){ .type = CMD_INPUT, .socket_fd = ctx->socket_fd, .direction = ctx->turns[0] })) {
+        log_client("FAILED: to queue direction\n");
+    }
+    for (size_t i = 1; i < ctx->turn_count; ++i) {
+        ctx->turns[i - 1] = ctx->turns[i];
+    }
+    ctx->turn_count--;
+    ctx->next_turn_at = timespec_add_ms(*now, (long)(1000 / (ctx->tick_rate > 0 ? ctx->tick_rate : GAME_TICK_RATE)));
+}
+
+// fills a frame with what the current mode shows, nothing in it points to state the main thread changes later
+static void build_frame(ClientContext *ctx, Frame *f) {
+    const Menu *menu = menu_current(&ctx->menus);
+    f->kind = FRAME_NONE;
+
+    if ((ctx->mode == CLIENT_MENU || ctx->mode == CLIENT_PAUSED || ctx->mode == CLIENT_GAME_OVER) && menu) {
+        f->kind = FRAME_MENU;
+        f->buttons = menu->buttons;
+        f->button_count = menu->button_count;
+        f->selected_index = menu->selected_index;
+        f->text_field_count = menu->txt_fields_count < MENU_MAX_TEXT_FIELDS ? menu->txt_fields_count : MENU_MAX_TEXT_FIELDS;
+        for (size_t i = 0; i < f->text_field_count; ++i) {
+            memcpy(f->text_fields[i], menu->txt_fields[i].text, MENU_MAX_TEXT_LENGTH);
+        }
+        f->input_mode = ctx->input_mode;
+        memcpy(f->text_note, ctx->text_note, sizeof(f->text_note));
+        memcpy(f->text_buffer, ctx->text_buffer, sizeof(f->text_buffer));
+        f->text_len = ctx->text_len;
+    }
+    else if (ctx->mode == CLIENT_PLAYING && snapshot_copy(&f->game, ctx->game) == 0) {
+        f->kind = FRAME_GAME;
+    }
+}
+
 /**
  * Runs the main client event loop.
  *
  * This function represents the central execution loop of the client.
  * It processes user input events and server messages asynchronously
- * using thread-safe queues and renders the current client state.
+ * using thread-safe queues and hands what should be on screen to the
+ * render thread.
  *
  * The loop performs the following steps repeatedly:
  *  - checks server process state
  *  - processes all pending keyboard input events
  *  - processes all pending server messages
- *  - renders either the active game or the current menu
+ *  - publishes a frame of the active game or the current menu if anything changed
+ *  - sleeps on the shared wakeup until new input arrives
  *
- * Input and network operations are handled in separate threads.
- * This function never blocks and runs until the client running
- * flag becomes false.
+ * Input and network operations are handled in separate threads which ring
+ * the wakeup, so keys and messages are handled as soon as they arrive.
+ * Terminal output happens on the render thread, so a slow terminal never
+ * delays input handling; frames it cannot keep up with are dropped. When
+ * idle the thread sleeps (waking up every CLIENT_IDLE_WAIT_MS to check
+ * the server process). Runs until the client running flag becomes false.
  *
- * @param ctx Client context holding application state
- * @param iq  Queue containing keyboard input events
- * @param sq  Queue containing messages received from the server
+ * @param ctx    Client context holding application state
+ * @param iq     Queue containing keyboard input events
+ * @param sq     Queue containing messages received from the server
+ * @param wakeup Wakeup rung by both queues
+ * @param frames Mailbox read by the render thread
  */
-void client_run(ClientContext *ctx, ClientInputQueue *iq, ServerInputQueue *sq) {
+void client_run(ClientContext *ctx, ClientInputQueue *iq, ServerInputQueue *sq, ClientWakeup *wakeup,
+                FrameMailbox *frames) {
+    bool dirty = true; // something changed since last published frame
+
     while (ctx->running) {
 
         // reaping server process if exited so we do not create zombies
+        const pid_t server_pid = ctx->server_pid;
         poll_server_exit(ctx);
+        if (ctx->server_pid != server_pid) dirty = true;
 
         // TODO setup timeout/retry for awaiting menu
         // e.g. servers game over, here we need to recv
         // async processing of keyboard signals, when too many we drop them
         Key key;
         while (dequeue_key(iq, &key)) {
+            dirty = true;
 
             if (ctx->input_mode == INPUT_TEXT) {
                 handle_text_input(ctx, key);
                 continue;
             }
 
+            if (ctx->mode == CLIENT_PLAYING) {
+                handle_game_key(ctx, key); // turns are buffered and paced, no need to drop keys
+                continue;
+            }
             if (ctx->mode == CLIENT_MENU || ctx->mode == CLIENT_PAUSED || ctx->mode == CLIENT_GAME_OVER) {
                 Menu *menu = menu_current(&ctx->menus);
                 handle_menu_key(menu, key);
             }
-            else if (ctx->mode == CLIENT_PLAYING) {
-                handle_game_key(ctx, key);
-            }
             client_input_queue_flush(iq);
         }
 
-        // async processing of server messages; when queue is full secondary thread waits
+        // newest decoded game state, older ones were dropped by the receive thread
+        if (state_mailbox_take(ctx->states, &ctx->game)) dirty = true;
+
+        // async processing of other server messages; when queue is full secondary thread waits
         Message msg; // message payload on heap needs freeing
         while (dequeue_msg(sq, &msg)) {
+            dirty = true;
+            // states published before this message was queued must be visible to it (e.g. final score)
+            state_mailbox_take(ctx->states, &ctx->game);
             handle_server_msg(ctx, msg);
             message_destroy(&msg);  // if payload_size > 0
         }
 
-        if (ctx->mode == CLIENT_MENU || ctx->mode == CLIENT_PAUSED || ctx->mode == CLIENT_GAME_OVER) {
-            render_menu(menu_current(&ctx->menus), ctx->input_mode, ctx->text_note, ctx->text_buffer, ctx->text_len);
-        }
-        else if (ctx->mode == CLIENT_PLAYING) {
-            render_game(ctx->game);
+        if (!ctx->running) break;
+
+        if (dirty) {
+            build_frame(ctx, frame_begin(frames));
+            frame_publish(frames);
+            dirty = false;
         }
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        send_paced_turn(ctx, &now);
+
+        // sleep until input arrives, the next buffered turn is due or idle check
+        struct timespec deadline = timespec_add_ms(now, CLIENT_IDLE_WAIT_MS);
+        if (ctx->turn_count > 0 && timespec_before(&ctx->next_turn_at, &deadline)) deadline = ctx->next_turn_at;
+        client_wakeup_wait_until(wakeup, &deadline);
     }
     // drain any remaining server messages so we do not leak memory
     Message msg; // message payload on heap needs freeing
@@ -95,21 +173,8 @@ void client_init(ClientContext *ctx) {
 
     ctx->input_mode = INPUT_KEY;
 
-    const ClientGameStateSnapshot state = {
-        .width = 0,
-        .height = 0,
-        .score = 0,
-        .game_time_remaining = 0,
-        .player_time_elapsed = 0,
-        .snake_count = 0,
-        .snakes = NULL,
-        .fruit_count = 0,
-        .fruits = NULL,
-        .obstacle_count = 0,
-        .obstacles = NULL
-    };
-
-    ctx->game = state;
+    ctx->game = NULL; // points into state mailbox once threads are set up
+    ctx->tick_rate = GAME_TICK_RATE;
 
     init_main_menu(ctx);
     init_pause_menu(ctx);
@@ -138,8 +203,6 @@ void client_cleanup(ClientContext *ctx) {
 
     disconnect_from_server(ctx);
 
-    snapshot_destroy(&ctx->game);
-
     term_show_cursor();
     term_clear();
     term_home();
@@ -216,6 +279,10 @@ bool spawn_server_process(ClientContext *ctx) {
             snprintf(time_arg, sizeof(time_arg), "-1");
         }
 
+        // server takes `--` options anywhere among its positional arguments
+        char rate_arg[32];
+        snprintf(rate_arg, sizeof(rate_arg), "--tick-rate=%d", ctx->spawn_tick_rate);
+
         execl("./serpent-server", "serpent-server",
             ctx->server_path,
             ctx->game_mode == GAME_SINGLE ? "1" : "0",
@@ -223,6 +290,7 @@ bool spawn_server_process(ClientContext *ctx) {
             ctx->obstacles_enabled ? "1" : "0",
             ctx->obstacles_enabled && ctx->random_world_enabled ? "1" : "0",
             ctx->obstacles_enabled && !ctx->random_world_enabled ? ctx->file_path : "",
+            ctx->spawn_tick_rate > 0 ? rate_arg : NULL,
             NULL);
         // if execl returns, there was an error
         perror("execl failed");
@@ -328,14 +396,17 @@ bool wait_for_server_socket(const char *path, int timeout_ms) {
 /**
  * Disconnects the client from the server.
  *
- * Closes the active socket connection if one exists and resets the
- * socket file descriptor in the client context.
+ * The socket is closed by the sender thread once every command queued
+ * before (e.g. leave) has been written; the socket file descriptor in the
+ * client context is reset immediately.
  *
  * @param ctx Pointer to the client context.
  */
 void disconnect_from_server(ClientContext *ctx) {
     if (ctx->socket_fd >= 0) {
-        close(ctx->socket_fd);
+        if (!enqueue_command(ctx->out, (Command){ .type = CMD_CLOSE, .socket_fd = ctx->socket_fd })) {
+            close(ctx->socket_fd); // sender already stopped
+        }
         ctx->socket_fd = -1;
     }
 }
@@ -653,14 +724,14 @@ void handle_game_key(ClientContext *ctx, const Key key) {
     if (key == KEY_QUIT || key == KEY_PAUSE || key == KEY_ESC) {
         ctx->mode = CLIENT_PAUSED;
 
-        log_client("sending message paused to server\n");
-        if (send_pause(ctx->socket_fd) < 0) {
-            log_client("FAILED: to send paused\n");
-        } else log_client("send\n");
+        log_client("queueing message paused to server\n");
+        if (!enqueue_command(ctx->out, (Command){ .type = CMD_PAUSE, .socket_fd = ctx->socket_fd })) {
+            log_client("FAILED: to queue paused\n");
+        }
 
         clear_menus_stack(&ctx->menus);
         snprintf(ctx->pause_menu.txt_fields[0].text, sizeof(ctx->pause_menu.txt_fields[0].text),
-             "Your current score is: %d Time in game is: %d s", (int)ctx->game.score, ctx->game.player_time_elapsed);
+             "Your current score is: %d Time in game is: %d s", (int)ctx->game->score, ctx->game->player_time_elapsed);
         menu_push(&ctx->menus, &ctx->pause_menu);
     }
 
@@ -682,10 +753,13 @@ void handle_game_key(ClientContext *ctx, const Key key) {
             return; // ignore other keys
     }
 
-    log_client("sending direction to server\n");
-    if (send_input(ctx->socket_fd, dir) < 0) {
-        log_client("FAILED: to send direction\n");
-    } else log_client("send\n");
+    // sent by the main loop one per tick, a repeat of the last buffered turn adds nothing
+    if (ctx->turn_count > 0 && ctx->turns[ctx->turn_count - 1] == dir) return;
+    if (ctx->turn_count == INPUT_TURN_BUFFER) {
+        ctx->turns[ctx->turn_count - 1] = dir; // full, newest press wins
+        return;
+    }
+    ctx->turns[ctx->turn_count++] = dir;
 }
 
 /**
@@ -709,34 +783,33 @@ void handle_server_msg(ClientContext *ctx, const Message msg) {
      * free payload after processing
      */
     switch (msg.type) {
-        case MSG_READY:
+        case MSG_READY: {
             ctx->mode = CLIENT_PLAYING;
-            log_client("msg ready received\n");
+            if (msg_to_ready(&msg, &ctx->tick_rate) < 0 || ctx->tick_rate == 0) ctx->tick_rate = GAME_TICK_RATE;
+            ctx->turn_count = 0;
+
+            char buf[64];
+            snprintf(buf, sizeof buf, "msg ready received, tick rate %u\n", (unsigned)ctx->tick_rate);
+            log_client(buf);
             break;
-        case MSG_GAME_OVER:
+        }
+        case MSG_GAME_OVER: {
+            // a player who already died gets the end of game broadcast too, keep its own result
+            if (ctx->mode == CLIENT_GAME_OVER) break;
             ctx->mode = CLIENT_GAME_OVER;
 
             clear_menus_stack(&ctx->menus);
             menu_push(&ctx->menus, &ctx->game_over_menu);
 
+            // the result comes with the message, the last state received may be a few ticks old
+            uint32_t score = (uint32_t)ctx->game->score;
+            uint32_t time_elapsed = (uint32_t)ctx->game->player_time_elapsed;
+            msg_to_game_over(&msg, &score, &time_elapsed);
+
             snprintf(ctx->game_over_menu.txt_fields[0].text, sizeof(ctx->game_over_menu.txt_fields[0].text),
-                     "Game over. Your score is: %d Time in game is: %d s", (int)ctx->game.score, ctx->game.player_time_elapsed);
+                     "Game over. Your score is: %d Time in game is: %d s", (int)score, (int)time_elapsed);
             log_client("msg game over received\n");
             break;
-        case MSG_STATE: {
-            ClientGameStateSnapshot new_state = {0};
-
-            if (msg_to_state(&msg, &new_state) == 0) {
-                snapshot_destroy(&ctx->game);   // free old
-                ctx->game = new_state;          // move ownership  TODO by value so is it ok ??????
-                log_client("game state updated\n");
-            } else {
-                snapshot_destroy(&new_state);
-                log_client("FAILED: to parse state message\n");
-            }
-
-            log_client("msg state received\n");
-            break;
         }
         case MSG_ERROR: {
             char error_msg[256];
@@ -908,7 +981,8 @@ void *recv_server_thread(void *arg) {
  *
  * This thread waits for incoming data on the server socket using poll(),
  * receives complete messages, and enqueues them into the server input queue
- * for processing by the main client thread.
+ * for processing by the main client thread. Game states are decoded here
+ * and published through the latest-only state mailbox instead.
  *
  * The thread periodically wakes up to check the running flag, allowing
  * graceful shutdown.
@@ -921,6 +995,7 @@ void *recv_server_thread(void *arg) {
 
     const int *socket_fd = args->socket_fd;
     ServerInputQueue *queue = args->queue;
+    StateMailbox *states = args->states;
     const _Atomic bool *running = args->running;
 
     // timeout in milliseconds (e.g. 100 ms)
@@ -961,9 +1036,76 @@ void *recv_server_thread(void *arg) {
                 // TODO: send event or stop running
                 continue;
             }
+            if (msg.type == MSG_STATE) {
+                // decoded here, main thread only sees the newest state
+                if (state_mailbox_publish(states, &msg) < 0) {
+                    log_client("FAILED: to parse state message\n");
+                }
+                message_destroy(&msg);
+                continue;
+            }
             enqueue_msg(queue, msg);
         }
     }
 
     return NULL;
-}
\ No newline at end of file
+}
+
+// writes one command to the server, blocking is fine here (sender thread only)
+static void exec_command(const Command *cmd) {
+    int rc = 0;
+    switch (cmd->type) {
+        case CMD_INPUT:
+            rc = send_input(cmd->socket_fd, cmd->direction);
+            break;
+        case CMD_PAUSE:
+            rc = send_pause(cmd->socket_fd);
+            break;
+        case CMD_RESUME:
+            rc = send_resume(cmd->socket_fd);
+            break;
+        case CMD_LEAVE:
+            rc = send_leave(cmd->socket_fd);
+            break;
+        case CMD_CLOSE:
+            close(cmd->socket_fd);
+            log_client("socket closed by sender\n");
+            break;
+        default:
+            break;
+    }
+    if (rc < 0) {
+        log_client("FAILED: to send command to server\n");
+    }
+}
+
+/**
+ * Thread function that writes queued commands to the server socket.
+ *
+ * The thread blocks on the output queue until the main thread enqueues a
+ * command, then drains all pending commands at once and sends them in
+ * order. Only this thread may block on send(), so key handling and
+ * rendering never stall on a backed up socket.
+ * The thread exits once the queue is closed and drained.
+ *
+ * @param arg Pointer to SendThreadArgs structure
+ * @return NULL when the thread exits
+ */
+void *send_server_thread(void *arg) {
+    const SendThreadArgs *args = arg;
+    ClientOutputQueue *queue = args->queue;
+
+    Command batch[MAX_COMMANDS];
+
+    while (client_output_queue_wait(queue)) {
+        const size_t n = drain_commands(queue, batch, MAX_COMMANDS);
+        for (size_t i = 0; i < n; ++i) {
+            exec_command(&batch[i]);
+        }
+    }
+
+    char buf[64];
+    snprintf(buf, sizeof buf, "sender done, %zu directions coalesced\n", queue->coalesced);
+    log_client(buf);
+    return NULL;
+}
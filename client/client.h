@@ -3,10 +3,12 @@
 
 #include "input.h"
 #include "context.h"
+#include "renderer.h"
 
 // client lifecycle
 void client_init(ClientContext *ctx);
-void client_run(ClientContext *ctx, ClientInputQueue *iq, ServerInputQueue *sq);
+void client_run(ClientContext *ctx, ClientInputQueue *iq, ServerInputQueue *sq, ClientWakeup *wakeup,
+                FrameMailbox *frames);
 void client_cleanup(ClientContext *ctx);
 
 // infrastructure
@@ -49,11 +51,17 @@ typedef struct {
 
 typedef struct {
     const int *socket_fd;
-    ServerInputQueue *queue;
+    ServerInputQueue *queue; // ordered non-state messages
+    StateMailbox *states; // decoded game states, latest only
     const _Atomic bool *running;
 } ReceiveThreadArgs;
 
+typedef struct {
+    ClientOutputQueue *queue; // thread exits once queue is closed and drained
+} SendThreadArgs;
+
 void *read_input_thread(void *arg);
 void *recv_server_thread(void *arg);
+void *send_server_thread(void *arg);
 
 #endif //SERPENT_CLIENT_H
\ No newline at end of file
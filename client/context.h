@@ -1,9 +1,12 @@
 #ifndef SERPENT_CONTEXT_H
 #define SERPENT_CONTEXT_H
 
+#include <time.h>
+#include "config.h"
 #include "menu.h"
 #include "types.h"
 #include "input.h"
+#include "output.h"
 
 
 typedef enum {
@@ -27,6 +30,7 @@ typedef struct {
     int socket_fd;  // socket file descriptor (unix domain sockets allow full duplex byte stream)
     char server_path[512]; // unix domain socket path
     pid_t server_pid; // if we spawned the server process
+    ClientOutputQueue *out; // everything sent to the server goes through sender thread
 
     volatile bool running;
     char error_message[512];
@@ -52,7 +56,14 @@ typedef struct {
     Menu error_menu;
 
     // current game state/rendering
-    ClientGameStateSnapshot game;
+    StateMailbox *states; // decoded by receive thread
+    const ClientGameStateSnapshot *game; // newest state taken from mailbox, valid until next take
+    uint32_t tick_rate; // game updates per second, told by server in MSG_READY, paces direction changes
+
+    // direction changes not sent yet, at most one goes out per tick so quick turns are not merged
+    Direction turns[INPUT_TURN_BUFFER];
+    size_t turn_count;
+    struct timespec next_turn_at; // earliest time the next one may be sent
 
     // game configuration options
     int time_remaining; // in seconds, -1 means no limit
@@ -60,6 +71,7 @@ typedef struct {
     char file_path[128];
     bool obstacles_enabled; // for hard world
     bool random_world_enabled; // random | from file
+    int spawn_tick_rate; // --tick-rate passed to a server we spawn, 0 leaves the server default
 
 } ClientContext;
 
@@ -1,4 +1,6 @@
+#define _POSIX_C_SOURCE 200112L
 #include "input.h"
+#include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <termios.h>
@@ -31,8 +33,54 @@ void read_keyboard_input(ClientInputQueue *queue, const _Atomic bool *running) {
     tcsetattr(STDIN_FILENO, TCSANOW, &old_tio);
 }
 
-void client_input_queue_init(ClientInputQueue *q) {
+void client_wakeup_init(ClientWakeup *w) {
+    w->pending = false;
+    pthread_mutex_init(&w->lock, NULL);
+
+    // deadlines are computed from CLOCK_MONOTONIC like the rest of the timing code
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&w->cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+void client_wakeup_destroy(ClientWakeup *w) {
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->cond);
+}
+
+void client_wakeup_signal(ClientWakeup *w) {
+    pthread_mutex_lock(&w->lock);
+    w->pending = true;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+/**
+ * Sleeps until some queue rings the wakeup or the deadline passes.
+ *
+ * A ring that happened since the previous wait returns immediately, so
+ * input enqueued while the main thread was busy is never missed.
+ *
+ * @param w        Pointer to the wakeup.
+ * @param deadline Absolute CLOCK_MONOTONIC time to give up at.
+ * @return true if woken by a producer, false on timeout.
+ */
+bool client_wakeup_wait_until(ClientWakeup *w, const struct timespec *deadline) {
+    pthread_mutex_lock(&w->lock);
+    while (!w->pending) {
+        if (pthread_cond_timedwait(&w->cond, &w->lock, deadline) == ETIMEDOUT) break;
+    }
+    const bool woken = w->pending;
+    w->pending = false;
+    pthread_mutex_unlock(&w->lock);
+    return woken;
+}
+
+void client_input_queue_init(ClientInputQueue *q, ClientWakeup *w) {
     q->count = 0;
+    q->wakeup = w;
     // events[] is left with indeterminate contents; that's fine as long as
     // you only read the first `count` entries.
     const int rc = pthread_mutex_init(&q->lock, NULL);
@@ -45,8 +93,9 @@ void client_input_queue_destroy(ClientInputQueue *q) {
     pthread_mutex_destroy(&q->lock);
 }
 
-void server_input_queue_init(ServerInputQueue *q) {
+void server_input_queue_init(ServerInputQueue *q, ClientWakeup *w) {
     q->count = 0;
+    q->wakeup = w;
     int rc = pthread_mutex_init(&q->lock, NULL);
     if (rc != 0) {
         // handle error
@@ -83,6 +132,8 @@ void enqueue_key(ClientInputQueue *q, const Key key) {
         q->events[q->count++] = key;
     }
     pthread_mutex_unlock(&q->lock);
+
+    client_wakeup_signal(q->wakeup);
 }
 
 /**
@@ -143,6 +194,8 @@ void enqueue_msg(ServerInputQueue *q, Message msg) {
     q->events[q->count++] = msg;
 
     pthread_mutex_unlock(&q->lock);
+
+    client_wakeup_signal(q->wakeup);
 }
 
 /**
@@ -181,4 +234,54 @@ bool dequeue_msg(ServerInputQueue *q, Message *msg) {
     return true;
 }
 
+void state_mailbox_init(StateMailbox *m, ClientWakeup *w) {
+    for (size_t i = 0; i < LEN(m->slots); ++i) {
+        ClientGameStateSnapshot *st = &m->slots[i];
+        *st = (ClientGameStateSnapshot){0};
+        snapshot_init(st);
+    }
+    tribuf_init(&m->tb, &m->slots[0], &m->slots[1], &m->slots[2]);
+    m->superseded = 0;
+    m->wakeup = w;
+}
+
+// both threads must be done with the mailbox
+void state_mailbox_destroy(StateMailbox *m) {
+    for (size_t i = 0; i < LEN(m->slots); ++i) {
+        snapshot_destroy(&m->slots[i]);
+    }
+}
+
+/**
+ * Decodes a MSG_STATE message and publishes it as the newest state.
+ *
+ * Called from the receive thread. The state is decoded straight into the
+ * mailbox's free slot (no allocation once slots are large enough) and then
+ * made visible to the main thread, replacing any state it has not taken yet.
+ *
+ * @param m   Pointer to the state mailbox.
+ * @param msg MSG_STATE message, not consumed.
+ * @return 0 on success, -1 if the message could not be decoded.
+ */
+int state_mailbox_publish(StateMailbox *m, const Message *msg) {
+    if (msg_to_state(msg, tribuf_back(&m->tb)) < 0) return -1;
+
+    if (tribuf_publish(&m->tb)) m->superseded++;
+    client_wakeup_signal(m->wakeup);
+    return 0;
+}
 
+/**
+ * Gives the main thread the newest decoded state.
+ *
+ * The returned snapshot stays valid and unchanged until the next call.
+ *
+ * @param m      Pointer to the state mailbox.
+ * @param latest Set to the newest state (an empty one before the first state).
+ * @return true if a new state arrived since the previous call.
+ */
+bool state_mailbox_take(StateMailbox *m, const ClientGameStateSnapshot **latest) {
+    const bool fresh = tribuf_acquire(&m->tb);
+    *latest = tribuf_front(&m->tb);
+    return fresh;
+}
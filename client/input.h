@@ -3,13 +3,24 @@
 
 #include "types.h"
 #include <pthread.h>
+#include <time.h>
 #include "protocol.h"
+#include "tribuf.h"
+
+// single wakeup shared by all queues feeding the main thread
+// producers ring it after enqueueing, main thread sleeps on it until a frame deadline
+typedef struct ClientWakeup {
+    bool pending; // rung since last wait
+    pthread_mutex_t lock;
+    pthread_cond_t cond; // CLOCK_MONOTONIC
+} ClientWakeup;
 
 typedef size_t Key;
 typedef struct ClientInputQueue {
     Key events[MAX_KEY_EVENTS];
     size_t count;
     pthread_mutex_t lock;
+    ClientWakeup *wakeup; // rung on every enqueued key
 } ClientInputQueue;
 
 typedef struct ServerInputQueue {
@@ -17,17 +28,32 @@ typedef struct ServerInputQueue {
     size_t count;
     pthread_mutex_t lock;
     pthread_cond_t not_full;
+    ClientWakeup *wakeup; // rung on every enqueued message
 } ServerInputQueue;
 
+// latest-only mailbox of decoded game states (receive thread -> main thread)
+// states superseded before the main thread looks are never copied or rendered
+typedef struct StateMailbox {
+    ClientGameStateSnapshot slots[3]; // decoded in place, array capacity is reused
+    TripleBuffer tb;
+    size_t superseded; // states replaced before being taken (receive thread only)
+    ClientWakeup *wakeup; // rung on every published state
+} StateMailbox;
+
 typedef enum {
     INPUT_TEXT, // text mode
     INPUT_KEY, // key mode
 } InputMode;
 
-void client_input_queue_init(ClientInputQueue *q);
+void client_wakeup_init(ClientWakeup *w);
+void client_wakeup_destroy(ClientWakeup *w);
+void client_wakeup_signal(ClientWakeup *w);
+bool client_wakeup_wait_until(ClientWakeup *w, const struct timespec *deadline);
+
+void client_input_queue_init(ClientInputQueue *q, ClientWakeup *w);
 void client_input_queue_destroy(ClientInputQueue *q);
 
-void server_input_queue_init(ServerInputQueue *q);
+void server_input_queue_init(ServerInputQueue *q, ClientWakeup *w);
 void server_input_queue_destroy(ServerInputQueue *q);
 
 void enqueue_key(ClientInputQueue *q, Key key);
@@ -37,6 +63,11 @@ void client_input_queue_flush(ClientInputQueue *q);
 void enqueue_msg(ServerInputQueue *q, Message msg);
 bool dequeue_msg(ServerInputQueue *q, Message *msg);
 
+void state_mailbox_init(StateMailbox *m, ClientWakeup *w);
+void state_mailbox_destroy(StateMailbox *m);
+int state_mailbox_publish(StateMailbox *m, const Message *msg);
+bool state_mailbox_take(StateMailbox *m, const ClientGameStateSnapshot **latest);
+
 void read_keyboard_input(ClientInputQueue *queue, const _Atomic bool *running);
 
 #endif //SERPENT_INPUT_H
\ No newline at end of file
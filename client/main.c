@@ -1,7 +1,28 @@
 #include <unistd.h>
 #include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "client.h"
 #include "logging.h"
+#include "config.h"
+
+// --tick-rate=N for servers this client spawns, 0 if not given, -1 on bad usage
+static int parse_tick_rate(const int argc, char *argv[]) {
+    int rate = 0;
+    for (int i = 1; i < argc; ++i) {
+        const char *value = strncmp(argv[i], "--tick-rate=", 12) == 0 ? argv[i] + 12 : NULL;
+        char *end = NULL;
+        const long r = value ? strtol(value, &end, 10) : -1;
+        if (!value || *end != '\0' || r < 1 || r > MAX_TICK_RATE) {
+            fprintf(stderr, "Usage: %s [--tick-rate=N]  game updates per second 1-%d of games it starts (default %d)\n",
+                    argv[0], MAX_TICK_RATE, GAME_TICK_RATE);
+            return -1;
+        }
+        rate = (int)r;
+    }
+    return rate;
+}
 
 int main(int argc, char *argv[]) {
     // globally ignore SIGPIPE to avoid crashes when writing to closed sockets
@@ -13,12 +34,29 @@ int main(int argc, char *argv[]) {
     log_client("____ SERPENT CLIENT STARTING ____\n");
 
     client_init(&ctx);
+    ctx.spawn_tick_rate = parse_tick_rate(argc, argv);
+    if (ctx.spawn_tick_rate < 0) return 1;
+
+    ClientWakeup wakeup; // rung by both input queues, main loop sleeps on it
+    client_wakeup_init(&wakeup);
 
     ClientInputQueue cq;
-    client_input_queue_init(&cq);
+    client_input_queue_init(&cq, &wakeup);
 
     ServerInputQueue sq;
-    server_input_queue_init(&sq);
+    server_input_queue_init(&sq, &wakeup);
+
+    StateMailbox states;
+    state_mailbox_init(&states, &wakeup);
+    ctx.states = &states;
+    state_mailbox_take(&states, &ctx.game); // empty state until server sends one
+
+    ClientOutputQueue oq;
+    client_output_queue_init(&oq);
+    ctx.out = &oq;
+
+    FrameMailbox frames;
+    frame_mailbox_init(&frames);
 
     _Atomic bool running = true;
     bool error = false;
@@ -29,13 +67,22 @@ int main(int argc, char *argv[]) {
     if (rc != 0) error = true;
 
     pthread_t recv_thread;
-    ReceiveThreadArgs recv_args = {&ctx.socket_fd, &sq, &running};
+    ReceiveThreadArgs recv_args = {&ctx.socket_fd, &sq, &states, &running};
     const int rc2 = pthread_create(&recv_thread, NULL, recv_server_thread, &recv_args);
     if (rc2 != 0) error = true;
 
+    pthread_t send_thread;
+    SendThreadArgs send_args = {&oq};
+    const int rc3 = pthread_create(&send_thread, NULL, send_server_thread, &send_args);
+    if (rc3 != 0) error = true;
+
+    pthread_t draw_thread;
+    const int rc4 = pthread_create(&draw_thread, NULL, render_thread, &frames);
+    if (rc4 != 0) error = true;
+
     log_client("Entering main client loop\n");
 
-    if (!error) client_run(&ctx, &cq, &sq);
+    if (!error) client_run(&ctx, &cq, &sq, &wakeup, &frames);
 
     log_client("Client ending\n");
 
@@ -46,10 +93,29 @@ int main(int argc, char *argv[]) {
     pthread_join(recv_thread, NULL);
     log_client("Receive thread joined\n");
 
+    disconnect_from_server(&ctx); // queued after any pending leave
+    client_output_queue_close(&oq);
+    pthread_join(send_thread, NULL);
+    log_client("Send thread joined\n");
+
+    frame_mailbox_close(&frames); // terminal is ours again once joined
+    pthread_join(draw_thread, NULL);
+    log_client("Render thread joined\n");
+
     client_cleanup(&ctx);
 
     client_input_queue_destroy(&cq);
     server_input_queue_destroy(&sq);
+    client_output_queue_destroy(&oq);
+
+    char buf[64];
+    snprintf(buf, sizeof buf, "%zu game states superseded before render\n", states.superseded);
+    log_client(buf);
+    snprintf(buf, sizeof buf, "%zu frames dropped before drawn\n", frames.dropped);
+    log_client(buf);
+    state_mailbox_destroy(&states);
+    frame_mailbox_destroy(&frames);
+    client_wakeup_destroy(&wakeup);
 
     log_client("____ SERPENT CLIENT EXITED ____\n");
 
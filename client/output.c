@@ -0,0 +1,96 @@
+#include "output.h"
+
+void client_output_queue_init(ClientOutputQueue *q) {
+    q->head = 0;
+    q->count = 0;
+    q->closed = false;
+    q->coalesced = 0;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+}
+
+void client_output_queue_destroy(ClientOutputQueue *q) {
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+}
+
+// wakes the sender so it drains what is left and exits
+void client_output_queue_close(ClientOutputQueue *q) {
+    pthread_mutex_lock(&q->lock);
+    q->closed = true;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/**
+ * Enqueues a command for the sender thread.
+ *
+ * A direction change replaces a direction still waiting at the back of the
+ * queue (socket is backed up, only the latest direction matters). When the
+ * queue is full direction changes are dropped, while control commands wait
+ * for space since losing a leave or close would leave the server hanging.
+ *
+ * @param q    Pointer to the output queue.
+ * @param cmd  Command to enqueue.
+ * @return false if the queue is closed or the command was dropped.
+ */
+bool enqueue_command(ClientOutputQueue *q, const Command cmd) {
+    pthread_mutex_lock(&q->lock);
+
+    if (cmd.type == CMD_INPUT && q->count > 0) {
+        Command *last = &q->commands[(q->head + q->count - 1) % MAX_COMMANDS];
+        if (last->type == CMD_INPUT && last->socket_fd == cmd.socket_fd) {
+            last->direction = cmd.direction;
+            q->coalesced++;
+            pthread_mutex_unlock(&q->lock);
+            return true;
+        }
+    }
+
+    while (q->count == MAX_COMMANDS && !q->closed) {
+        if (cmd.type == CMD_INPUT) {
+            pthread_mutex_unlock(&q->lock);
+            return false;
+        }
+        pthread_cond_wait(&q->not_full, &q->lock);
+    }
+    if (q->closed) {
+        pthread_mutex_unlock(&q->lock);
+        return false;
+    }
+
+    q->commands[(q->head + q->count) % MAX_COMMANDS] = cmd;
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+
+    pthread_mutex_unlock(&q->lock);
+    return true;
+}
+
+// blocks until there is a command, returns false once closed and empty
+bool client_output_queue_wait(ClientOutputQueue *q) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !q->closed) {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+    const bool has_work = q->count > 0;
+    pthread_mutex_unlock(&q->lock);
+    return has_work;
+}
+
+// takes up to max pending commands in FIFO order under one lock acquisition
+size_t drain_commands(ClientOutputQueue *q, Command *buf, const size_t max) {
+    pthread_mutex_lock(&q->lock);
+    const size_t n = q->count < max ? q->count : max;
+    for (size_t i = 0; i < n; ++i) {
+        buf[i] = q->commands[(q->head + i) % MAX_COMMANDS];
+    }
+    q->head = (q->head + n) % MAX_COMMANDS;
+    q->count -= n;
+    if (n > 0) pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
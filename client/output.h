@@ -0,0 +1,44 @@
+#ifndef SERPENT_OUTPUT_H
+#define SERPENT_OUTPUT_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "types.h"
+
+// commands from main thread to sender thread (everything the client writes to the server)
+typedef enum {
+    CMD_INPUT, // send direction, consecutive pending inputs are coalesced
+    CMD_PAUSE,
+    CMD_RESUME,
+    CMD_LEAVE,
+    CMD_CLOSE, // close the socket once everything queued before it has been sent
+} CommandType;
+
+typedef struct {
+    CommandType type;
+    int socket_fd; // connection the command belongs to (main thread may reconnect meanwhile)
+    Direction direction; // CMD_INPUT only
+} Command;
+
+// outbound command queue
+// main thread never blocks on the socket, the sender thread does the (blocking) writes
+typedef struct ClientOutputQueue {
+    Command commands[MAX_COMMANDS]; // ring buffer
+    size_t head;
+    size_t count;
+    bool closed; // set on shutdown so a waiting sender returns
+    size_t coalesced; // direction changes replaced before being sent
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} ClientOutputQueue;
+
+void client_output_queue_init(ClientOutputQueue *q);
+void client_output_queue_destroy(ClientOutputQueue *q);
+void client_output_queue_close(ClientOutputQueue *q);
+
+bool enqueue_command(ClientOutputQueue *q, Command cmd);
+bool client_output_queue_wait(ClientOutputQueue *q);
+size_t drain_commands(ClientOutputQueue *q, Command *buf, size_t max);
+
+#endif //SERPENT_OUTPUT_H
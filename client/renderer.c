@@ -1,9 +1,12 @@
+#define _POSIX_C_SOURCE 199309L
 #include "config.h"
 #include "renderer.h"
+#include "timer.h"
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
-#include "timer.h"
 
 
 void term_clear(void) {
@@ -47,7 +50,7 @@ void draw_box(const int x, const int y, const int w, const int h) {
     }
 }
 
-void render_menu(const Menu *menu, const InputMode input_mode, const char *text_note, const char *text_buffer, const size_t text_len) {
+void render_menu(const Frame *f) {
 
     TermSize ts;
     term_get_size(&ts);
@@ -62,33 +65,29 @@ void render_menu(const Menu *menu, const InputMode input_mode, const char *text_
     draw_text(x_pos, 2, "___S E R P E N T___");
     draw_text(x_pos - 2, 3, "The Terminal Snake Game");
 
-    if (input_mode == INPUT_TEXT) {
+    if (f->input_mode == INPUT_TEXT) {
 
-        draw_text(ts.cols / 7, y_pos - 1, text_note);
-        printf("\033[%d;%dH%.*s", y_pos, ts.cols / 7, (int)text_len, text_buffer);
-        draw_text(ts.cols / 7 + (int)text_len, y_pos, "_");
+        draw_text(ts.cols / 7, y_pos - 1, f->text_note);
+        printf("\033[%d;%dH%.*s", y_pos, ts.cols / 7, (int)f->text_len, f->text_buffer);
+        draw_text(ts.cols / 7 + (int)f->text_len, y_pos, "_");
     }
 
     // render menu buttons
-    for (size_t i = 0; i < menu->button_count; ++i) {
-        const Button *b = &menu->buttons[i];
+    for (size_t i = 0; i < f->button_count; ++i) {
+        const Button *b = &f->buttons[i];
 
-        if (i == menu->selected_index)
+        if (i == f->selected_index)
             draw_text(x_pos - 2, y_pos + (int)i * 2, ">");
 
         draw_text(x_pos, y_pos + (int)i * 2, b->text);
     }
 
     // render menu text fields
-    for (size_t i = 0; i < menu->txt_fields_count; ++i) {
-        const TextField *t = &menu->txt_fields[i];
-
-        draw_text(ts.cols / 20, y_pos / 3, t->text);
+    for (size_t i = 0; i < f->text_field_count; ++i) {
+        draw_text(ts.cols / 20, y_pos / 3, f->text_fields[i]);
     }
 
     fflush(stdout);
-
-    sleep_frame(FRAME_TIME_MS);
 }
 
 
@@ -144,8 +143,87 @@ void render_game(const ClientGameStateSnapshot state) {
     }
 
     fflush(stdout);
+}
+
+
+void frame_mailbox_init(FrameMailbox *m) {
+    for (size_t i = 0; i < LEN(m->slots); ++i) {
+        Frame *f = &m->slots[i];
+        memset(f, 0, sizeof(*f));
+        f->kind = FRAME_NONE;
+        snapshot_init(&f->game);
+    }
+    tribuf_init(&m->tb, &m->slots[0], &m->slots[1], &m->slots[2]);
+    client_wakeup_init(&m->ready);
+    atomic_init(&m->closed, false);
+    m->dropped = 0;
+}
+
+// render thread must be joined
+void frame_mailbox_destroy(FrameMailbox *m) {
+    for (size_t i = 0; i < LEN(m->slots); ++i) {
+        snapshot_destroy(&m->slots[i].game);
+    }
+    client_wakeup_destroy(&m->ready);
+}
+
+// asks render thread to exit
+void frame_mailbox_close(FrameMailbox *m) {
+    atomic_store(&m->closed, true);
+    client_wakeup_signal(&m->ready);
+}
+
+// slot the main thread builds the next frame in, not seen by the render thread
+Frame *frame_begin(FrameMailbox *m) {
+    return tribuf_back(&m->tb);
+}
 
-    sleep_frame(FRAME_TIME_MS);
+// hands the built frame over, replacing one the render thread has not drawn yet
+void frame_publish(FrameMailbox *m) {
+    if (tribuf_publish(&m->tb)) m->dropped++;
+    client_wakeup_signal(&m->ready);
 }
 
+static void render_frame(const Frame *f) {
+    switch (f->kind) {
+        case FRAME_MENU:
+            render_menu(f);
+            break;
+        case FRAME_GAME:
+            render_game(f->game);
+            break;
+        default:
+            break;
+    }
+}
 
+/**
+ * Render thread, the only thread writing to the terminal while the client runs.
+ *
+ * Sleeps until the main thread publishes a frame, waits for the next
+ * frame slot of its own TickClock and draws the newest frame; frames
+ * published while it is drawing or waiting replace each other, so only
+ * the latest gets drawn and at most TARGET_FPS frames per second.
+ *
+ * @param arg  Pointer to the FrameMailbox.
+ * @return NULL once the mailbox is closed.
+ */
+void *render_thread(void *arg) {
+    FrameMailbox *m = arg;
+
+    TickClock pace; // after idle the next slot is due at once, missed slots are skipped
+    tick_clock_init(&pace, 1000000000LL / TARGET_FPS, TICK_SKIP);
+
+    while (!atomic_load(&m->closed)) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const struct timespec idle = timespec_add_ms(now, CLIENT_IDLE_WAIT_MS);
+        client_wakeup_wait_until(&m->ready, &idle);
+
+        if (atomic_load(&m->closed)) break;
+
+        tick_clock_wait(&pace);
+        if (tribuf_acquire(&m->tb)) render_frame(tribuf_front(&m->tb));
+    }
+    return NULL;
+}
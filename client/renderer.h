@@ -2,6 +2,7 @@
 #define SERPENT_RENDERER_H
 
 #include <stdlib.h>
+#include <stdatomic.h>
 #include "types.h"
 #include "menu.h"
 #include "input.h"
@@ -11,11 +12,55 @@ typedef struct {
     int rows;
 } TermSize;
 
+typedef enum {
+    FRAME_NONE, // nothing to draw (connecting, exiting)
+    FRAME_MENU,
+    FRAME_GAME,
+} FrameKind;
 
-void render_menu(const Menu *menu, InputMode input_mode, const char *text_note,
-    const char *text_buffer, size_t text_len);
+// everything the render thread draws, built by the main thread and left
+// untouched once published
+typedef struct {
+    FrameKind kind;
+
+    // menu frames, button labels are static and only referenced, text fields change and are copied
+    const Button *buttons;
+    size_t button_count;
+    size_t selected_index;
+    char text_fields[MENU_MAX_TEXT_FIELDS][MENU_MAX_TEXT_LENGTH];
+    size_t text_field_count;
+    InputMode input_mode;
+    char text_note[128];
+    char text_buffer[128];
+    size_t text_len;
+
+    // game frames, own copy of the state (array capacity is reused between frames)
+    ClientGameStateSnapshot game;
+} Frame;
+
+// latest-only hand-off of frames (main thread -> render thread)
+// a slow terminal only makes frames get dropped, the main thread never waits for it
+typedef struct {
+    Frame slots[3];
+    TripleBuffer tb;
+    ClientWakeup ready; // rung on every published frame
+    _Atomic bool closed;
+    size_t dropped; // frames replaced before being drawn (main thread only)
+} FrameMailbox;
+
+void frame_mailbox_init(FrameMailbox *m);
+void frame_mailbox_destroy(FrameMailbox *m);
+void frame_mailbox_close(FrameMailbox *m);
+Frame *frame_begin(FrameMailbox *m);
+void frame_publish(FrameMailbox *m);
+
+void *render_thread(void *arg);
+
+void render_menu(const Frame *f);
 void render_game(ClientGameStateSnapshot state);
 
+
+
 void term_clear(void);
 void term_home(void);
 void term_hide_cursor(void);
@@ -7,21 +7,48 @@
 #define CLIENT_LOG_FILE "client_log.txt"
 
 #define INITIAL_SNAKE_LENGTH 3
+#define SPAWN_CLEARANCE 3 // empty cells required in front of a joining snake's head
+#define SPAWN_HEAD_CLEARANCE 5 // default distance a joining snake keeps from live heads (--head-clearance)
+#define MAX_SPAWN_HEAD_CLEARANCE 100
+#define SPAWN_CANDIDATES 32 // clear spawn places scored against live heads per join
 
 #define WORLD_WIDTH 90
 #define WORLD_HEIGHT 40
 #define WORLD_X_OFFSET 20
 #define WORLD_Y_OFFSET 6
 
-#define MAX_EVENTS 1024
-#define MAX_ACTIONS 1024
+#define CACHE_LINE_SIZE 64 // used to pad shared atomics so producers and consumer do not false share
+
+#define MAX_PLAYERS 256 // concurrently connected players (player handle slots)
+#define MAX_FRUITS MAX_PLAYERS // fruits on the board, one per join up to this
+#define MAX_EVENTS 1024 // must be a power of two (ring buffer index masking)
+#define MAX_ACTIONS 1024 // per action priority lane
+#define MAX_BULK_BATCH 64 // bulk actions handed to worker at once, control actions can cut in between
 #define MAX_KEY_EVENTS 16
 #define MAX_MESSAGES 1024
+#define MAX_COMMANDS 64 // client commands waiting for the sender thread
+#define MAX_REACTOR_EVENTS 256 // epoll events handled per reactor wakeup
+#define MAX_OUTBOUND 64 // queued messages per client before it is considered stalled
+#define SHUTDOWN_LINGER_MS 500 // time given to flush pending output on shutdown
+#define MAX_TIMERS 4096 // pending timers in the game loop timer wheel
+
+#define RESUME_WAIT_MS 3000 // delay before resumed player moves again
+#define END_WAIT_MS 10000 // delay before shutdown after last player left (multiplayer)
 
 #define TARGET_FPS 60 // frames per second for rendering
 #define FRAME_TIME_MS (1000 / TARGET_FPS)
+#define CLIENT_IDLE_WAIT_MS 100 // longest client sleep when nothing happens (server process exit check)
 #define GAME_TICK_RATE 15 // game updates per second .. sort of speed
 #define GAME_TICK_TIME_MS (1000 / GAME_TICK_RATE)
+#define MAX_TICK_RATE 100 // highest --tick-rate accepted by the server
+#define INPUT_TURN_BUFFER 3 // client: direction changes kept when pressed faster than the game ticks
+#define SNAPSHOT_SHED_PERCENT 75 // adaptive snapshots: tick cost (of budget) above which snapshots are skipped
+#define SNAPSHOT_RESTORE_PERCENT 40 // ... and below which the snapshot rate goes back up
+#define SNAPSHOT_MAX_EVERY 4 // at least every 4th tick still sends a snapshot
+#define SNAPSHOT_HOLD_TICKS 16 // ticks between snapshot rate changes
+#define IDLE_HEARTBEAT_MS 1000 // snapshot interval while nothing in the game can change
+#define FIRST_PLAYER_TIMEOUT_MS 10000 // server gives up when nobody connects in time
+#define TICK_MAX_CATCH_UP 4 // late ticks run back to back before the rest is skipped
 
 #define SNAKE_CHAR "o"
 #define FRUIT_CHAR "*"
@@ -39,5 +66,6 @@
 
 #define MENU_MAX_TEXT_LENGTH 512
 #define MENU_STACK_MAX 12
+#define MENU_MAX_TEXT_FIELDS 4 // text fields copied into a render frame
 
 #endif //SERPENT_CONFIG_H
\ No newline at end of file
@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200112L
 #include <stdio.h>
 #include <time.h>
 #include "logging.h"
@@ -6,7 +7,8 @@
 
 void log_message(const char *message, const char *filename) {
     time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
+    struct tm tm_buf;
+    const struct tm *timeinfo = localtime_r(&now, &tm_buf); // logged from several threads at once
     char timestamp[32];
     size_t written = 0;
     if (timeinfo) {
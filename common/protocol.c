@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/socket.h>
 #include <arpa/inet.h>
 
 // message framing ... sockets are byte streams
@@ -66,6 +67,78 @@ void message_destroy(Message *msg) {
     msg->payload_size = 0;
 }
 
+void msg_reader_init(MsgReader *r) {
+    r->received = 0;
+    r->payload = NULL;
+}
+
+void msg_reader_destroy(MsgReader *r) {
+    free(r->payload);
+    msg_reader_init(r);
+}
+
+/**
+ * Reads whatever is available of the next message without blocking.
+ *
+ * Meant for event loops: receives the remaining part of the header and then
+ * the payload using MSG_DONTWAIT, keeping partial progress in the reader so
+ * the call can be repeated when the socket becomes readable again.
+ * Call repeatedly until it returns 0 to consume all buffered messages.
+ *
+ * @param fd   Socket file descriptor.
+ * @param r    Reader holding partial message state for this socket.
+ * @param msg  Filled with the complete message when 1 is returned.
+ * @return 1 if a complete message was received, 0 if more data is needed,
+ *         -1 on error or peer disconnect.
+ *
+ * @note The caller is responsible for freeing msg->payload when payload_size > 0.
+ */
+int msg_reader_feed(const int fd, MsgReader *r, Message *msg) {
+    if (!r || !msg)
+        return -1;
+
+    // header
+    while (r->received < sizeof(r->header)) {
+        const ssize_t n = recv(fd, (char *)&r->header + r->received,
+                               sizeof(r->header) - r->received, MSG_DONTWAIT);
+        if (n == 0) return -1; // peer closed
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;
+        }
+        r->received += (size_t)n;
+    }
+
+    // payload
+    const size_t payload_size = r->header.payload_size;
+    if (payload_size > 0 && !r->payload) {
+        r->payload = malloc(payload_size);
+        if (!r->payload) return -1;
+    }
+
+    while (r->received < sizeof(r->header) + payload_size) {
+        const size_t off = r->received - sizeof(r->header);
+        const ssize_t n = recv(fd, r->payload + off, payload_size - off, MSG_DONTWAIT);
+        if (n == 0) return -1;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;
+        }
+        r->received += (size_t)n;
+    }
+
+    // complete, ownership of payload moves to msg
+    msg->type = (MessageType)r->header.type;
+    msg->payload_size = r->header.payload_size;
+    msg->payload = r->payload;
+
+    r->received = 0;
+    r->payload = NULL;
+    return 1;
+}
+
 // payload is owned by msg, this func must be used synchronously (main thread/ worker thread)
 // as we do no heap allocate
 /**
@@ -190,11 +263,12 @@ int send_leave(const int fd) {
     return send_message(fd, &msg);
 }
 
-int send_ready(const int fd) {
+int send_ready(const int fd, const uint32_t tick_rate) {
+    ReadyWire w = { .tick_rate = tick_rate };
     Message msg;
     msg.type = MSG_READY;
-    msg.payload_size = 0;
-    msg.payload = NULL;
+    msg.payload_size = sizeof(w);
+    msg.payload = &w;
     return send_message(fd, &msg);
 }
 
@@ -207,17 +281,17 @@ int send_game_over(const int fd) {
 }
 
 /**
- * Sends a serialized snapshot of the current client game state.
+ * Serializes a client game state snapshot into a MSG_STATE message.
  *
  * The game state is packed into a single contiguous payload consisting of
  * a fixed-size header followed by variable-length arrays (snakes, fruits,
- * obstacles). The payload is then sent as a MSG_STATE message.
+ * obstacles).
  *
- * @param fd  Socket file descriptor.
- * @param st  Pointer to the client game state snapshot.
+ * @param st   Pointer to the client game state snapshot.
+ * @param msg  Filled with the message, payload is heap allocated and owned by msg.
  * @return 0 on success, -1 on error.
  */
-int send_state(const int fd, const ClientGameStateSnapshot *st) {
+int state_to_msg(const ClientGameStateSnapshot *st, Message *msg) {
     // we pack data as header + arrays (bytes)
     // other message does need this as they have no dynamic arrays
     const GameStateWireHeader h = {
@@ -266,18 +340,104 @@ int send_state(const int fd, const ClientGameStateSnapshot *st) {
     p += st->fruit_count * sizeof(Fruit);
     memcpy(p, st->obstacles, st->obstacle_count * sizeof(Obstacle));
 
-    const Message msg = {
-        .type = MSG_STATE,
-        .payload_size = payload_size,
-        .payload = buf,
-    };
+    msg->type = MSG_STATE;
+    msg->payload_size = payload_size;
+    msg->payload = buf;
+
+    return 0;
+}
+
+/**
+ * Copies an encoded MSG_STATE and rewrites its per-player header fields.
+ *
+ * Everything but score and time in game is the same for all players, so
+ * a tick's state is serialized once and only the header differs per copy.
+ *
+ * @param shared               MSG_STATE produced by state_to_msg(), not consumed.
+ * @param score                Score of the receiving player.
+ * @param player_time_elapsed  Seconds the receiving player has been in game.
+ * @param msg                  Filled with the copy, payload owned by msg.
+ * @return 0 on success, -1 on error.
+ */
+int state_msg_for_player(const Message *shared, const uint32_t score, const uint32_t player_time_elapsed,
+                         Message *msg) {
+    if (!shared || !msg || shared->type != MSG_STATE || shared->payload_size < sizeof(GameStateWireHeader)) {
+        return -1;
+    }
+
+    void *buf = malloc(shared->payload_size);
+    if (!buf) return -1;
+    memcpy(buf, shared->payload, shared->payload_size);
+
+    GameStateWireHeader h;
+    memcpy(&h, buf, sizeof(h));
+    h.score = score;
+    h.player_time_elapsed = player_time_elapsed;
+    memcpy(buf, &h, sizeof(h));
+
+    msg->type = MSG_STATE;
+    msg->payload_size = shared->payload_size;
+    msg->payload = buf;
+    return 0;
+}
+
+/**
+ * Sends a serialized snapshot of the current client game state.
+ *
+ * @param fd  Socket file descriptor.
+ * @param st  Pointer to the client game state snapshot.
+ * @return 0 on success, -1 on error.
+ */
+int send_state(const int fd, const ClientGameStateSnapshot *st) {
+    Message msg;
+    if (state_to_msg(st, &msg) < 0) return -1;
 
     const int rc = send_message(fd, &msg);
-    free(buf);
+    message_destroy(&msg);
 
     return rc;
 }
 
+// copies error text into an owned payload (including null terminator)
+int error_to_msg(const char *error_msg, Message *msg) {
+    if (!error_msg || !msg) return -1;
+    const size_t len = strlen(error_msg) + 1;
+
+    msg->payload = malloc(len);
+    if (!msg->payload) return -1;
+    memcpy(msg->payload, error_msg, len);
+
+    msg->type = MSG_ERROR;
+    msg->payload_size = (uint32_t)len;
+    return 0;
+}
+
+int ready_to_msg(const uint32_t tick_rate, Message *msg) {
+    if (!msg) return -1;
+    const ReadyWire w = { .tick_rate = tick_rate };
+
+    msg->payload = malloc(sizeof(w));
+    if (!msg->payload) return -1;
+    memcpy(msg->payload, &w, sizeof(w));
+
+    msg->type = MSG_READY;
+    msg->payload_size = sizeof(w);
+    return 0;
+}
+
+int game_over_to_msg(const uint32_t score, const uint32_t player_time_elapsed, Message *msg) {
+    if (!msg) return -1;
+    const GameOverWire w = { .score = score, .player_time_elapsed = player_time_elapsed };
+
+    msg->payload = malloc(sizeof(w));
+    if (!msg->payload) return -1;
+    memcpy(msg->payload, &w, sizeof(w));
+
+    msg->type = MSG_GAME_OVER;
+    msg->payload_size = sizeof(w);
+    return 0;
+}
+
 int send_error(const int fd, const char *error_msg) {
     if (!error_msg) return -1;
     Message msg;
@@ -287,13 +447,15 @@ int send_error(const int fd, const char *error_msg) {
     return send_message(fd, &msg);
 }
 
-// dynamically allocates arrays inside st, caller must free them
 /**
  * Converts a MSG_STATE message payload into a client game state snapshot.
  *
- * Deserializes the wire-format payload into dynamically allocated game state
- * structures. The caller becomes the owner of all allocated memory and must
- * free it using snapshot_destroy().
+ * Deserializes the wire-format payload into the arrays of `st`, which only
+ * grow when the new state does not fit, so decoding repeatedly into the
+ * same snapshot allocates nothing once it is large enough. The snapshot
+ * must be initialized (snapshot_init() or a previous decode) and is freed
+ * using snapshot_destroy(). On error `st` stays valid but its contents are
+ * unspecified.
  *
  * @param msg  Pointer to the received message.
  * @param st   Pointer to the destination game state snapshot.
@@ -310,42 +472,35 @@ int msg_to_state(const Message *msg, ClientGameStateSnapshot *st) {
     memcpy(&h, p, sizeof(h));
     p += sizeof(h);
 
+    if (reserve_items((void **)&st->snakes, &st->snake_capacity, h.snake_count, sizeof(SnakeSnapshot)) < 0 ||
+        reserve_items((void **)&st->fruits, &st->fruit_capacity, h.fruit_count, sizeof(Fruit)) < 0 ||
+        reserve_items((void **)&st->obstacles, &st->obstacle_capacity, h.obstacle_count, sizeof(Obstacle)) < 0) {
+        return -1;
+    }
+
     st->width  = (int)h.width;
     st->height = (int)h.height;
     st->score  = h.score;
     st->player_time_elapsed = (int)h.player_time_elapsed;
     st->game_time_remaining = (int)h.game_time_remaining;
 
-    // allocate
-
     st->snake_count = h.snake_count;
-    st->snakes = malloc(h.snake_count * sizeof(SnakeSnapshot));
-
     for (size_t i = 0; i < st->snake_count; i++) {
         uint32_t len;
         memcpy(&len, p, sizeof(len));
         p += sizeof(len);
 
-        st->snakes[i].length = len;
-        st->snakes[i].body = malloc(len * sizeof(Position));
-
-        if (!st->snakes[i].body) {
-            snapshot_destroy(st);
+        SnakeSnapshot *s = &st->snakes[i];
+        if (reserve_items((void **)&s->body, &s->capacity, len, sizeof(Position)) < 0) {
+            st->snake_count = i;
             return -1;
         }
+        s->length = len;
 
-        memcpy(st->snakes[i].body, p, len * sizeof(Position));
+        memcpy(s->body, p, len * sizeof(Position));
         p += len * sizeof(Position);
     }
 
-    st->fruits    = malloc(h.fruit_count * sizeof(Fruit));
-    st->obstacles = malloc(h.obstacle_count * sizeof(Obstacle));
-
-    if (!st->snakes || !st->fruits || !st->obstacles) {
-        snapshot_destroy(st);
-        return -1;
-    }
-
     st->fruit_count  = h.fruit_count;
     st->obstacle_count = h.obstacle_count;
 
@@ -391,6 +546,45 @@ int msg_to_error(const Message *msg, char *error_msg, const size_t buf_size) {
     return 0;
 }
 
+int msg_to_ready(const Message *msg, uint32_t *tick_rate) {
+    if (!msg || !tick_rate || msg->type != MSG_READY) return -1;
+
+    if (msg->payload_size == 0) {
+        *tick_rate = GAME_TICK_RATE; // server without configurable rate
+        return 0;
+    }
+    if (msg->payload_size != sizeof(ReadyWire) || !msg->payload) return -1;
+
+    ReadyWire w;
+    memcpy(&w, msg->payload, sizeof(w));
+    *tick_rate = w.tick_rate;
+    return 0;
+}
+
+/**
+ * Reads the final result carried by a MSG_GAME_OVER message.
+ *
+ * A message without payload leaves both outputs untouched, so the caller
+ * can fill them with what it already knows beforehand.
+ *
+ * @param msg                  MSG_GAME_OVER message.
+ * @param score                Receives the player's final score.
+ * @param player_time_elapsed  Receives the player's time in game in seconds.
+ * @return 0 on success, -1 on a malformed message.
+ */
+int msg_to_game_over(const Message *msg, uint32_t *score, uint32_t *player_time_elapsed) {
+    if (!msg || !score || !player_time_elapsed || msg->type != MSG_GAME_OVER) return -1;
+
+    if (msg->payload_size == 0) return 0;
+    if (msg->payload_size != sizeof(GameOverWire) || !msg->payload) return -1;
+
+    GameOverWire w;
+    memcpy(&w, msg->payload, sizeof(w));
+    *score = w.score;
+    *player_time_elapsed = w.player_time_elapsed;
+    return 0;
+}
+
 
 // portable serde ... network byte order ... avoiding for simplicity
 /*
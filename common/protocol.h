@@ -45,8 +45,28 @@ typedef struct {
     uint32_t obstacle_count;
 } GameStateWireHeader;
 
+// wire payload of ready message, empty payload means defaults (GAME_TICK_RATE)
+typedef struct {
+    uint32_t tick_rate; // game updates per second chosen by the server
+} ReadyWire;
+
+// wire payload of game over message, the player's final result
+// empty payload means unknown (client keeps what its last state showed)
+typedef struct {
+    uint32_t score;
+    uint32_t player_time_elapsed; // in seconds
+} GameOverWire;
+
 
 
+// incremental reader for non-blocking sockets (event loop)
+// keeps partially received header/payload between calls
+typedef struct {
+    MsgHeader header;
+    size_t received; // bytes received of current header + payload
+    uint8_t *payload;
+} MsgReader;
+
 static int send_all(int fd, const void *buf, size_t size);
 static int recv_all(int fd, void *buf, size_t size);
 
@@ -57,21 +77,34 @@ int recv_message(int fd, Message *msg);
 
 void message_destroy(Message *msg);
 
+void msg_reader_init(MsgReader *r);
+void msg_reader_destroy(MsgReader *r);
+int msg_reader_feed(int fd, MsgReader *r, Message *msg);
+
 // specializations for convenience
 // type -> payload mapping -> message -> byte send ->
 int send_input(int fd, Direction dir);
 int send_pause(int fd);
 int send_resume(int fd);
 int send_leave(int fd);
-int send_ready(int fd);
+int send_ready(int fd, uint32_t tick_rate);
 int send_game_over(int fd);
 int send_state(int fd, const ClientGameStateSnapshot *st);
 int send_error(int fd, const char *error_msg);
 
+// type -> payload mapping -> message (owned payload, for queued/non-blocking sending)
+int state_to_msg(const ClientGameStateSnapshot *st, Message *msg);
+int state_msg_for_player(const Message *shared, uint32_t score, uint32_t player_time_elapsed, Message *msg);
+int error_to_msg(const char *error_msg, Message *msg);
+int ready_to_msg(uint32_t tick_rate, Message *msg);
+int game_over_to_msg(uint32_t score, uint32_t player_time_elapsed, Message *msg);
+
 // (byte recv -> message ... done elsewhere i.e. not called recv_input ...)
 // message -> payload mapping -> type
 int msg_to_input(const Message *msg, Direction *dir);
 int msg_to_state(const Message *msg, ClientGameStateSnapshot *st);
 int msg_to_error(const Message *msg, char *error_msg, size_t buf_size);
+int msg_to_ready(const Message *msg, uint32_t *tick_rate);
+int msg_to_game_over(const Message *msg, uint32_t *score, uint32_t *player_time_elapsed);
 
 #endif //SERPENT_PROTOCOL_H
\ No newline at end of file
@@ -1,6 +1,8 @@
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200112L
 #include "timer.h"
 #include <time.h>
+#include <errno.h>
+#include "config.h"
 
 #include "logging.h"
 
@@ -11,32 +13,6 @@ void sleepn(const long nanoseconds) {
     nanosleep(&ts, NULL);
 }
 
-void sleep_frame(const long sleep_time_ms) {
-    static struct timespec last_frame = {0};
-    struct timespec current_time, sleep_time;
-    long elapsed_ms, sleep_ms;
-
-    clock_gettime(CLOCK_MONOTONIC, &current_time);
-
-    if (last_frame.tv_sec == 0 && last_frame.tv_nsec == 0) {
-        last_frame = current_time;
-        return;
-    }
-
-    elapsed_ms = (current_time.tv_sec - last_frame.tv_sec) * 1000 +
-                 (current_time.tv_nsec - last_frame.tv_nsec) / 1000000;
-
-    sleep_ms = sleep_time_ms - elapsed_ms;
-
-    if (sleep_ms > 0) {
-        sleep_time.tv_sec = sleep_ms / 1000;
-        sleep_time.tv_nsec = (sleep_ms % 1000) * 1000000;
-        nanosleep(&sleep_time, NULL);
-    }
-
-    clock_gettime(CLOCK_MONOTONIC, &last_frame);
-}
-
 static double timespec_diff_sec(const struct timespec *start,
                                 const struct timespec *end) {
     time_t sec = end->tv_sec - start->tv_sec;
@@ -59,19 +35,139 @@ void timer_reset(Timer *t) {
 }
 
 double timer_remaining(const Timer *t) {
-    if (t->duration_sec <= 0.0) return -1.0;
-    const double elapsed = timer_elapsed(t);
-    const double remaining = t->duration_sec - elapsed;
-    return remaining > 0.0 ? remaining : 0.0;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timer_remaining_at(t, &now);
 }
 
 double timer_elapsed(const Timer *t) {
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
-    return timespec_diff_sec(&t->start_time, &now);
+    return timer_elapsed_at(t, &now);
 }
 
 bool timer_expired(const Timer *t) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timer_expired_at(t, &now);
+}
+
+// variants against a time taken once per tick (see tick_clock_now)
+double timer_remaining_at(const Timer *t, const struct timespec *now) {
+    if (t->duration_sec <= 0.0) return -1.0;
+    const double remaining = t->duration_sec - timer_elapsed_at(t, now);
+    return remaining > 0.0 ? remaining : 0.0;
+}
+
+double timer_elapsed_at(const Timer *t, const struct timespec *now) {
+    return timespec_diff_sec(&t->start_time, now);
+}
+
+bool timer_expired_at(const Timer *t, const struct timespec *now) {
     if (t->duration_sec <= 0.0) return true;
-    return timer_elapsed(t) >= t->duration_sec;
-}
\ No newline at end of file
+    return timer_elapsed_at(t, now) >= t->duration_sec;
+}
+
+struct timespec timespec_add_ms(struct timespec t, const long ms) {
+    t.tv_sec += ms / 1000;
+    t.tv_nsec += (ms % 1000) * 1000000L;
+    if (t.tv_nsec >= 1000000000L) {
+        t.tv_sec++;
+        t.tv_nsec -= 1000000000L;
+    }
+    return t;
+}
+
+bool timespec_before(const struct timespec *a, const struct timespec *b) {
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+static int64_t timespec_ns(const struct timespec *t) {
+    return (int64_t)t->tv_sec * 1000000000LL + t->tv_nsec;
+}
+
+static struct timespec ns_timespec(const int64_t ns) {
+    return (struct timespec){ .tv_sec = (time_t)(ns / 1000000000LL), .tv_nsec = (long)(ns % 1000000000LL) };
+}
+
+/**
+ * Prepares a tick clock whose first tick is due right away.
+ *
+ * @param c          Pointer to the clock.
+ * @param period_ns  Tick period in nanoseconds.
+ * @param policy     What to do with deadlines missed on overrun.
+ */
+void tick_clock_init(TickClock *c, const int64_t period_ns, const TickPolicy policy) {
+    clock_gettime(CLOCK_MONOTONIC, &c->now);
+    c->next_ns = timespec_ns(&c->now);
+    c->period_ns = period_ns;
+    c->policy = policy;
+    c->max_catch_up = TICK_MAX_CATCH_UP;
+    c->behind = 0;
+    c->ticks = 0;
+    c->overruns = 0;
+    c->skipped = 0;
+    c->late_ns = 0;
+    c->max_late_ns = 0;
+}
+
+/**
+ * Sleeps until the next tick deadline and starts that tick.
+ *
+ * Deadlines are absolute and advance by exactly one period, so time spent
+ * in the tick itself never shifts the schedule. When a tick starts a whole
+ * period or more late, TICK_CATCH_UP runs the missed ticks back to back
+ * (at most max_catch_up in a row) while TICK_SKIP drops them and keeps
+ * the original phase.
+ *
+ * @param c  Pointer to the clock.
+ * @return Start time of the tick, the same value tick_clock_now() returns until the next call.
+ */
+const struct timespec *tick_clock_wait(TickClock *c) {
+    const struct timespec deadline = ns_timespec(c->next_ns);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {}
+
+    clock_gettime(CLOCK_MONOTONIC, &c->now);
+    const int64_t now_ns = timespec_ns(&c->now);
+
+    c->late_ns = now_ns > c->next_ns ? now_ns - c->next_ns : 0;
+    if (c->late_ns > c->max_late_ns) c->max_late_ns = c->late_ns;
+    c->ticks++;
+    c->next_ns += c->period_ns;
+
+    if (now_ns >= c->next_ns) {
+        c->overruns++;
+        if (c->policy == TICK_SKIP || c->behind >= c->max_catch_up) {
+            const int64_t missed = (now_ns - c->next_ns) / c->period_ns + 1;
+            c->next_ns += missed * c->period_ns;
+            c->skipped += (uint64_t)missed;
+            c->behind = 0;
+        } else {
+            c->behind++;
+        }
+    } else {
+        c->behind = 0;
+    }
+    return &c->now;
+}
+
+// start time of the current tick, one clock read shared by everything in it
+const struct timespec *tick_clock_now(const TickClock *c) {
+    return &c->now;
+}
+
+// time spent in the current tick so far (its cost when called at the end)
+int64_t tick_clock_elapsed_ns(const TickClock *c) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_ns(&now) - timespec_ns(&c->now);
+}
+
+// restarts the schedule from now after the loop slept on purpose, so the
+// next tick runs right away and the pause is not counted as late or skipped ticks
+void tick_clock_resync(TickClock *c) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    c->next_ns = timespec_ns(&now);
+    c->behind = 0;
+}
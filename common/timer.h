@@ -3,11 +3,10 @@
 
 #include <time.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 void sleepn(long nanoseconds);
 
-void sleep_frame(long sleep_time_ms);
-
 typedef struct {
     struct timespec start_time;
     double duration_sec;
@@ -24,4 +23,39 @@ double timer_elapsed(const Timer *t);
 
 bool timer_expired(const Timer *t);
 
+double timer_remaining_at(const Timer *t, const struct timespec *now);
+double timer_elapsed_at(const Timer *t, const struct timespec *now);
+bool timer_expired_at(const Timer *t, const struct timespec *now);
+
+typedef enum {
+    TICK_CATCH_UP, // missed ticks run back to back (bounded by max_catch_up)
+    TICK_SKIP, // missed ticks are dropped, schedule keeps its phase
+} TickPolicy;
+
+// fixed timestep pacing against absolute CLOCK_MONOTONIC deadlines, one instance per loop
+typedef struct {
+    struct timespec now; // start of the current tick, read once per tick
+    int64_t next_ns; // deadline of the next tick
+    int64_t period_ns;
+    TickPolicy policy;
+    unsigned max_catch_up;
+    unsigned behind; // late ticks run back to back so far
+
+    uint64_t ticks;
+    uint64_t overruns; // ticks started a whole period or more late
+    uint64_t skipped; // deadlines dropped
+    int64_t late_ns; // how late the current tick started
+    int64_t max_late_ns;
+} TickClock;
+
+void tick_clock_init(TickClock *c, int64_t period_ns, TickPolicy policy);
+const struct timespec *tick_clock_wait(TickClock *c);
+const struct timespec *tick_clock_now(const TickClock *c);
+int64_t tick_clock_elapsed_ns(const TickClock *c);
+void tick_clock_resync(TickClock *c);
+
+// absolute CLOCK_MONOTONIC deadlines
+struct timespec timespec_add_ms(struct timespec t, long ms);
+bool timespec_before(const struct timespec *a, const struct timespec *b);
+
 #endif //SERPENT_TIMER_H
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "tribuf.h"
+
+void tribuf_init(TripleBuffer *tb, void *a, void *b, void *c) {
+    tb->slots[0] = a;
+    tb->slots[1] = b;
+    tb->slots[2] = c;
+    tb->front = 0;
+    atomic_init(&tb->middle, 1);
+    tb->back = 2;
+}
+
+// slot the writer may fill, not visible to reader until published
+void *tribuf_back(const TripleBuffer *tb) {
+    return tb->slots[tb->back];
+}
+
+/**
+ * Publishes the writer's back slot as the newest value.
+ *
+ * The back slot is exchanged with the slot in transit, which becomes the
+ * writer's next back slot (its contents can be reused, e.g. buffer capacity).
+ *
+ * @param tb  Pointer to the triple buffer.
+ * @return true if an unread value was replaced (reader fell behind).
+ */
+bool tribuf_publish(TripleBuffer *tb) {
+    const unsigned old = atomic_exchange_explicit(&tb->middle, tb->back | TRIBUF_FRESH,
+                                                  memory_order_acq_rel);
+    tb->back = old & ~TRIBUF_FRESH;
+    return (old & TRIBUF_FRESH) != 0;
+}
+
+/**
+ * Makes the newest published value the reader's front slot.
+ *
+ * @param tb  Pointer to the triple buffer.
+ * @return true if front changed, false if nothing new was published.
+ */
+bool tribuf_acquire(TripleBuffer *tb) {
+    if (!(atomic_load_explicit(&tb->middle, memory_order_relaxed) & TRIBUF_FRESH)) return false;
+
+    const unsigned old = atomic_exchange_explicit(&tb->middle, tb->front, memory_order_acq_rel);
+    tb->front = old & ~TRIBUF_FRESH;
+    return true;
+}
+
+// slot the reader owns until the next acquire
+void *tribuf_front(const TripleBuffer *tb) {
+    return tb->slots[tb->front];
+}
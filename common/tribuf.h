@@ -0,0 +1,27 @@
+#ifndef SERPENT_TRIBUF_H
+#define SERPENT_TRIBUF_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// single-producer/single-consumer triple buffer (latest value only, lock-free)
+// writer fills its back slot and publishes it, reader takes the newest published
+// slot as its front; neither side ever waits and unread values are simply replaced
+#define TRIBUF_FRESH 4u // flag in `middle`: published slot not taken by reader yet
+
+typedef struct {
+    void *slots[3];
+    _Atomic unsigned middle; // slot index in transit (| TRIBUF_FRESH)
+    unsigned back; // writer only
+    unsigned front; // reader only
+} TripleBuffer;
+
+void tribuf_init(TripleBuffer *tb, void *a, void *b, void *c);
+
+void *tribuf_back(const TripleBuffer *tb);
+bool tribuf_publish(TripleBuffer *tb);
+
+bool tribuf_acquire(TripleBuffer *tb);
+void *tribuf_front(const TripleBuffer *tb);
+
+#endif //SERPENT_TRIBUF_H
@@ -1,6 +1,7 @@
 #include "types.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 void snapshot_init(ClientGameStateSnapshot *st) {
     st->snakes = NULL;
@@ -9,11 +10,16 @@ void snapshot_init(ClientGameStateSnapshot *st) {
     st->fruit_count = 0;
     st->obstacles = NULL;
     st->obstacle_count = 0;
+    st->snake_capacity = 0;
+    st->fruit_capacity = 0;
+    st->obstacle_capacity = 0;
 }
 
 void snapshot_destroy(ClientGameStateSnapshot *st) {
     if (st->snakes) {
-        for (size_t i = 0; i < st->snake_count; ++i) {
+        // reused snapshots keep bodies of unused entries up to capacity
+        const size_t n = st->snake_capacity > st->snake_count ? st->snake_capacity : st->snake_count;
+        for (size_t i = 0; i < n; ++i) {
             free(st->snakes[i].body);
         }
         free(st->snakes);
@@ -21,4 +27,59 @@ void snapshot_destroy(ClientGameStateSnapshot *st) {
     free(st->fruits);
     free(st->obstacles);
     snapshot_init(st);
-}
\ No newline at end of file
+}
+
+// grows array to hold n items, new items are zeroed, existing capacity is kept
+int reserve_items(void **items, size_t *capacity, const size_t n, const size_t item_size) {
+    if (n <= *capacity) return 0;
+
+    void *tmp = realloc(*items, n * item_size);
+    if (!tmp) return -1;
+    memset((uint8_t *)tmp + *capacity * item_size, 0, (n - *capacity) * item_size);
+    *items = tmp;
+    *capacity = n;
+    return 0;
+}
+
+/**
+ * Copies a snapshot into another one, reusing the destination's arrays.
+ *
+ * Like msg_to_state(), arrays only grow when `src` does not fit, so
+ * copying repeatedly into the same snapshot stops allocating. On error
+ * `dst` stays valid but its contents are unspecified.
+ *
+ * @param dst  Initialized destination snapshot.
+ * @param src  Snapshot to copy.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int snapshot_copy(ClientGameStateSnapshot *dst, const ClientGameStateSnapshot *src) {
+    if (reserve_items((void **)&dst->snakes, &dst->snake_capacity, src->snake_count, sizeof(SnakeSnapshot)) < 0 ||
+        reserve_items((void **)&dst->fruits, &dst->fruit_capacity, src->fruit_count, sizeof(Fruit)) < 0 ||
+        reserve_items((void **)&dst->obstacles, &dst->obstacle_capacity, src->obstacle_count, sizeof(Obstacle)) < 0) {
+        return -1;
+    }
+
+    dst->width = src->width;
+    dst->height = src->height;
+    dst->score = src->score;
+    dst->player_time_elapsed = src->player_time_elapsed;
+    dst->game_time_remaining = src->game_time_remaining;
+
+    dst->snake_count = src->snake_count;
+    for (size_t i = 0; i < src->snake_count; ++i) {
+        SnakeSnapshot *s = &dst->snakes[i];
+        const size_t len = src->snakes[i].length;
+        if (reserve_items((void **)&s->body, &s->capacity, len, sizeof(Position)) < 0) {
+            dst->snake_count = i;
+            return -1;
+        }
+        memcpy(s->body, src->snakes[i].body, len * sizeof(Position));
+        s->length = len;
+    }
+
+    dst->fruit_count = src->fruit_count;
+    memcpy(dst->fruits, src->fruits, src->fruit_count * sizeof(Fruit));
+    dst->obstacle_count = src->obstacle_count;
+    memcpy(dst->obstacles, src->obstacles, src->obstacle_count * sizeof(Obstacle));
+    return 0;
+}
@@ -35,6 +35,7 @@ typedef struct {
 typedef struct {
     Position *body;
     size_t length;
+    size_t capacity; // allocated body length, kept when snapshot is decoded into again
 } SnakeSnapshot;
 
 typedef struct {
@@ -54,9 +55,17 @@ typedef struct {
 
     size_t obstacle_count;
     Obstacle *obstacles;
+
+    // allocated array lengths (0 when arrays are sized exactly by count)
+    size_t snake_capacity;
+    size_t fruit_capacity;
+    size_t obstacle_capacity;
 } ClientGameStateSnapshot;
 
 void snapshot_init(ClientGameStateSnapshot *st);
 void snapshot_destroy(ClientGameStateSnapshot *st);
+int snapshot_copy(ClientGameStateSnapshot *dst, const ClientGameStateSnapshot *src);
+
+int reserve_items(void **items, size_t *capacity, size_t n, size_t item_size);
 
 #endif //SERPENT_GAME_TYPES_H
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "bodies.h"
+#include <stdlib.h>
+
+// a free body's first bytes hold the link, so no class is smaller than a pointer
+typedef struct FreeBody {
+    struct FreeBody *next;
+} FreeBody;
+
+// free list for a power-of-two capacity
+static size_t body_class(size_t capacity) {
+    size_t c = 0;
+    while (capacity > 1) {
+        capacity >>= 1;
+        c++;
+    }
+    return c;
+}
+
+static size_t body_bytes(const size_t capacity) {
+    const size_t bytes = capacity * sizeof(Position);
+    return bytes < sizeof(FreeBody) ? sizeof(FreeBody) : bytes;
+}
+
+void body_pool_init(BodyPool *b) {
+    for (size_t i = 0; i < BODY_CLASSES; ++i) {
+        b->free[i] = NULL;
+    }
+    b->cached = 0;
+    b->allocated = 0;
+}
+
+// every live body must have been given back first
+void body_pool_destroy(BodyPool *b) {
+    for (size_t i = 0; i < BODY_CLASSES; ++i) {
+        FreeBody *f = b->free[i];
+        while (f) {
+            FreeBody *next = f->next;
+            free(f);
+            f = next;
+        }
+        b->free[i] = NULL;
+    }
+    b->cached = 0;
+}
+
+/**
+ * Stocks a size class up front so the first bodies of that size come without heap traffic.
+ *
+ * @param b         Pointer to the pool.
+ * @param capacity  Ring capacity, a power of two.
+ * @param count     Bodies to add to the class.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int body_pool_reserve(BodyPool *b, const size_t capacity, const size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        Position *body = malloc(body_bytes(capacity));
+        if (!body) return -1;
+        b->allocated++;
+        body_free(b, body, capacity);
+    }
+    return 0;
+}
+
+/**
+ * Takes a body for a ring of the given capacity, reusing a freed one when there is one.
+ *
+ * @param b         Pointer to the pool.
+ * @param capacity  Ring capacity, a power of two.
+ * @return The body, or NULL if its class was empty and malloc failed.
+ */
+Position *body_alloc(BodyPool *b, const size_t capacity) {
+    const size_t c = body_class(capacity);
+    FreeBody *f = b->free[c];
+    if (f) {
+        b->free[c] = f->next;
+        b->cached--;
+        return (Position *)f;
+    }
+
+    Position *body = malloc(body_bytes(capacity));
+    if (body) b->allocated++;
+    return body;
+}
+
+// gives a body back to its class, capacity must be the one it was taken with
+void body_free(BodyPool *b, Position *body, const size_t capacity) {
+    if (!body) return;
+    const size_t c = body_class(capacity);
+    FreeBody *f = (FreeBody *)body;
+    f->next = b->free[c];
+    b->free[c] = f;
+    b->cached++;
+}
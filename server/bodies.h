@@ -0,0 +1,25 @@
+#ifndef SERPENT_BODIES_H
+#define SERPENT_BODIES_H
+
+#include <stddef.h>
+#include "types.h"
+
+#define BODY_CLASSES 32 // capacities 1 << 0 .. 1 << 31 positions
+
+// size-class allocator for snake bodies: a ring's capacity is always a power of two, so every
+// capacity has its own free list and a body given back is handed out again for the next ring
+// of that size, the heap is only touched the first time a class runs dry
+typedef struct {
+    void *free[BODY_CLASSES]; // singly linked through the first bytes of each free body
+    size_t cached; // bodies sitting in free lists
+    size_t allocated; // bodies ever taken from the heap
+} BodyPool;
+
+void body_pool_init(BodyPool *b);
+void body_pool_destroy(BodyPool *b);
+int body_pool_reserve(BodyPool *b, size_t capacity, size_t count);
+
+Position *body_alloc(BodyPool *b, size_t capacity);
+void body_free(BodyPool *b, Position *body, size_t capacity);
+
+#endif //SERPENT_BODIES_H
@@ -0,0 +1,112 @@
+#include "cellset.h"
+#include <stdlib.h>
+
+/**
+ * Sets up a set holding every cell of the rectangle [x0, x1] x [y0, y1].
+ *
+ * Nothing is written per cell, the zeroed arrays already describe the
+ * rectangle filled row by row; an empty rectangle gives an empty set.
+ *
+ * @param s       Pointer to the set.
+ * @param width   Board width.
+ * @param height  Board height.
+ * @return 0 on success, -1 if allocation failed (nothing is left to destroy then).
+ */
+int cell_set_init(CellSet *s, const int width, const int height, const int x0, const int x1, const int y0,
+                  const int y1) {
+    const size_t cells = (size_t)width * (size_t)height;
+    const bool empty = x1 < x0 || y1 < y0;
+    s->width = width;
+    s->x0 = x0;
+    s->x1 = x1;
+    s->y0 = y0;
+    s->y1 = y1;
+    s->count = empty ? 0 : (size_t)(x1 - x0 + 1) * (size_t)(y1 - y0 + 1);
+
+    // members never outnumber the rectangle, calloc leaves both untouched until used
+    s->members = calloc(s->count > 0 ? s->count : 1, sizeof(uint32_t));
+    s->slot = calloc(cells > 0 ? cells : 1, sizeof(uint32_t));
+    if (!s->members || !s->slot) {
+        cell_set_destroy(s);
+        return -1;
+    }
+    return 0;
+}
+
+void cell_set_destroy(CellSet *s) {
+    free(s->members);
+    free(s->slot);
+    s->members = NULL;
+    s->slot = NULL;
+    s->count = 0;
+}
+
+static bool in_rect(const CellSet *s, const size_t cell) {
+    const int x = (int)(cell % (size_t)s->width);
+    const int y = (int)(cell / (size_t)s->width);
+    return x >= s->x0 && x <= s->x1 && y >= s->y0 && y <= s->y1;
+}
+
+// index the initial fill gave a cell of the rectangle
+static uint32_t initial_index(const CellSet *s, const size_t cell) {
+    const size_t x = cell % (size_t)s->width;
+    const size_t y = cell / (size_t)s->width;
+    const size_t row = (size_t)(s->x1 - s->x0 + 1);
+    return (uint32_t)((y - (size_t)s->y0) * row + (x - (size_t)s->x0));
+}
+
+// cell the initial fill put at an index
+static size_t initial_cell(const CellSet *s, const size_t i) {
+    const size_t row = (size_t)(s->x1 - s->x0 + 1);
+    return ((size_t)s->y0 + i / row) * (size_t)s->width + (size_t)s->x0 + i % row;
+}
+
+static uint32_t index_of(const CellSet *s, const size_t cell) {
+    const uint32_t v = s->slot[cell];
+    if (v == CELL_SET_OUT) return CELL_SET_OUT;
+    return v == 0 ? initial_index(s, cell) : v - 1;
+}
+
+// i-th member (i < count)
+size_t cell_set_at(const CellSet *s, const size_t i) {
+    const uint32_t v = s->members[i];
+    return v == 0 ? initial_cell(s, i) : v - 1;
+}
+
+bool cell_set_holds(const CellSet *s, const size_t cell) {
+    return in_rect(s, cell) && index_of(s, cell) != CELL_SET_OUT;
+}
+
+// moves the last member into the cell's place, no-op if not a member
+void cell_set_remove(CellSet *s, const size_t cell) {
+    if (!in_rect(s, cell)) return;
+    const uint32_t i = index_of(s, cell);
+    if (i == CELL_SET_OUT) return;
+
+    const size_t last = cell_set_at(s, --s->count);
+    s->members[i] = (uint32_t)last + 1;
+    s->slot[last] = i + 1;
+    s->slot[cell] = CELL_SET_OUT;
+}
+
+// cells outside the rectangle are never members, must not be a member already
+void cell_set_add(CellSet *s, const size_t cell) {
+    if (!in_rect(s, cell)) return;
+
+    s->slot[cell] = (uint32_t)s->count + 1;
+    s->members[s->count++] = (uint32_t)cell + 1;
+}
+
+/**
+ * Picks a uniformly random member in O(1).
+ *
+ * @param s     Pointer to the set.
+ * @param cell  Receives the picked cell.
+ * @return true on success, false if the set is empty.
+ */
+bool cell_set_pick(const CellSet *s, size_t *cell) {
+    if (s->count == 0) return false;
+
+    *cell = cell_set_at(s, (size_t)rand() % s->count);
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef SERPENT_CELLSET_H
+#define SERPENT_CELLSET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// set of board cells with O(1) add, remove and uniform pick, as a dense array of members
+// plus each cell's index in it; only cells of one rectangle can be members and the set
+// starts out holding all of them
+// both arrays start zeroed and zero means "where the initial fill would have put it", so
+// setting up a set is one calloc per array and only pages that changed are ever touched
+typedef struct {
+    int width; // board width, cells are y * width + x
+    int x0, x1; // member rectangle, inclusive
+    int y0, y1;
+    uint32_t *members; // index in set -> cell + 1, 0 = initial member at that index
+    uint32_t *slot; // cell -> index in set + 1, 0 = initial index, CELL_SET_OUT if not a member
+    size_t count;
+} CellSet;
+
+#define CELL_SET_OUT UINT32_MAX
+
+int cell_set_init(CellSet *s, int width, int height, int x0, int x1, int y0, int y1);
+void cell_set_destroy(CellSet *s);
+
+bool cell_set_holds(const CellSet *s, size_t cell);
+void cell_set_add(CellSet *s, size_t cell);
+void cell_set_remove(CellSet *s, size_t cell);
+bool cell_set_pick(const CellSet *s, size_t *cell);
+size_t cell_set_at(const CellSet *s, size_t i);
+
+#endif //SERPENT_CELLSET_H
@@ -0,0 +1,149 @@
+#include "encoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "protocol.h"
+#include "logging.h"
+
+int encoder_init(SnapshotEncoder *e, ActionQueue *aq) {
+    memset(e, 0, sizeof(*e));
+    tribuf_init(&e->tb, &e->slots[0], &e->slots[1], &e->slots[2]);
+    e->aq = aq;
+
+    if (pthread_mutex_init(&e->lock, NULL) != 0) {
+        log_server("FAILED: to init encoder mutex\n");
+        return -1;
+    }
+    if (pthread_cond_init(&e->cond, NULL) != 0) {
+        log_server("FAILED: to init encoder cond\n");
+        pthread_mutex_destroy(&e->lock);
+        return -1;
+    }
+    return 0;
+}
+
+// encoder thread must be joined
+void encoder_destroy(SnapshotEncoder *e) {
+    for (size_t i = 0; i < LEN(e->slots); ++i) {
+        WorldFrame *f = &e->slots[i];
+        free(f->players);
+        free(f->bodies);
+        free(f->fruits);
+        free(f->obstacles);
+    }
+    free(e->snakes);
+    pthread_mutex_destroy(&e->lock);
+    pthread_cond_destroy(&e->cond);
+}
+
+// asks encoder thread to exit, a frame still waiting is dropped
+void encoder_close(SnapshotEncoder *e) {
+    pthread_mutex_lock(&e->lock);
+    e->closed = true;
+    pthread_cond_signal(&e->cond);
+    pthread_mutex_unlock(&e->lock);
+}
+
+void encoder_log_stats(const SnapshotEncoder *e) {
+    char buf[128];
+    snprintf(buf, sizeof buf, "encoder: %llu frames encoded, %zu superseded before encoding\n",
+             (unsigned long long)e->encoded, e->superseded);
+    log_server(buf);
+}
+
+// frame the tick thread fills next, never read by the encoder until published
+WorldFrame *encoder_frame_begin(SnapshotEncoder *e) {
+    return tribuf_back(&e->tb);
+}
+
+// hands the filled frame to the encoder, replacing one it has not started on
+void encoder_frame_publish(SnapshotEncoder *e) {
+    if (tribuf_publish(&e->tb)) e->superseded++;
+
+    pthread_mutex_lock(&e->lock);
+    e->pending = true;
+    pthread_cond_signal(&e->cond);
+    pthread_mutex_unlock(&e->lock);
+}
+
+// sleeps until a frame is published, false once closed
+static bool encoder_wait(SnapshotEncoder *e) {
+    pthread_mutex_lock(&e->lock);
+    while (!e->pending && !e->closed) {
+        pthread_cond_wait(&e->cond, &e->lock);
+    }
+    const bool open = !e->closed;
+    e->pending = false;
+    pthread_mutex_unlock(&e->lock);
+    return open;
+}
+
+/**
+ * Serializes a frame once and queues a copy for every player.
+ *
+ * The shared message is built from views into the frame (no copying of
+ * bodies), each player's copy only differs in its header.
+ *
+ * @param e  Pointer to the encoder.
+ * @param f  Frame taken from the triple buffer, read only.
+ */
+static void encode_frame(SnapshotEncoder *e, const WorldFrame *f) {
+    if (f->player_count == 0) return;
+    if (reserve_items((void **)&e->snakes, &e->snake_capacity, f->player_count, sizeof(SnakeSnapshot)) < 0) {
+        log_server("FAILED: to allocate encoder snake views\n");
+        return;
+    }
+
+    for (size_t i = 0; i < f->player_count; ++i) {
+        e->snakes[i].body = &f->bodies[f->players[i].body_start];
+        e->snakes[i].length = f->players[i].length;
+    }
+
+    const ClientGameStateSnapshot view = {
+        .width = f->width,
+        .height = f->height,
+        .game_time_remaining = f->game_time_remaining,
+        .snake_count = f->player_count,
+        .snakes = e->snakes,
+        .fruit_count = f->fruit_count,
+        .fruits = f->fruits,
+        .obstacle_count = f->obstacle_count,
+        .obstacles = f->obstacles,
+    };
+
+    Message shared;
+    if (state_to_msg(&view, &shared) < 0) {
+        log_server("FAILED: to encode game state\n");
+        return;
+    }
+    e->encoded++;
+
+    for (size_t i = 0; i < f->player_count; ++i) {
+        const FramePlayer *p = &f->players[i];
+        Action act = { .type = ACT_SEND_GAME_STATE, .u.game.player = p->handle };
+        if (state_msg_for_player(&shared, p->score, p->time_elapsed, &act.u.game.msg) < 0) continue;
+        enqueue_action(e->aq, act);
+    }
+    message_destroy(&shared);
+}
+
+/**
+ * Encoder thread, turns published world frames into queued snapshot messages.
+ *
+ * Runs next to the tick thread so serializing and copying snapshots for
+ * every player is off the tick's critical path. Frames published faster
+ * than they can be encoded replace each other, only the newest is sent.
+ *
+ * @param arg  Pointer to the SnapshotEncoder.
+ * @return NULL once the encoder is closed.
+ */
+void *encoder_thread(void *arg) {
+    SnapshotEncoder *e = arg;
+
+    while (encoder_wait(e)) {
+        if (!tribuf_acquire(&e->tb)) continue;
+        encode_frame(e, tribuf_front(&e->tb));
+    }
+    log_server("THREAD: ENCODER completed\n");
+    return NULL;
+}
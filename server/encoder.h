@@ -0,0 +1,76 @@
+#ifndef SERPENT_ENCODER_H
+#define SERPENT_ENCODER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+#include "handles.h"
+#include "tribuf.h"
+#include "events.h"
+
+typedef struct {
+    PlayerHandle handle;
+    uint32_t score;
+    uint32_t time_elapsed; // seconds in game at the end of the tick
+    size_t body_start; // first position in WorldFrame.bodies
+    size_t length;
+} FramePlayer;
+
+// read-only copy of the world at the end of a tick, everything the snapshots need
+// arrays keep their capacity between ticks so steady state copying allocates nothing
+typedef struct {
+    uint64_t tick;
+    int width;
+    int height;
+    int game_time_remaining;
+
+    FramePlayer *players;
+    size_t player_count;
+    size_t player_capacity;
+
+    Position *bodies; // all snake bodies back to back
+    size_t body_count;
+    size_t body_capacity;
+
+    Fruit *fruits;
+    size_t fruit_count;
+    size_t fruit_capacity;
+
+    Obstacle *obstacles;
+    size_t obstacle_count;
+    size_t obstacle_capacity;
+} WorldFrame;
+
+// encoder stage between the tick thread and the worker: the tick thread publishes a
+// frozen WorldFrame and goes on simulating, the encoder thread serializes the newest
+// frame once, copies it per player and queues the messages as bulk actions
+typedef struct {
+    WorldFrame slots[3];
+    TripleBuffer tb;
+    ActionQueue *aq;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool pending; // frame published since encoder last looked
+    bool closed;
+
+    // encoder thread only
+    SnakeSnapshot *snakes; // view of the frame's snakes for state_to_msg
+    size_t snake_capacity;
+    uint64_t encoded; // frames serialized
+
+    size_t superseded; // frames replaced before being encoded (tick thread only)
+} SnapshotEncoder;
+
+int encoder_init(SnapshotEncoder *e, ActionQueue *aq);
+void encoder_destroy(SnapshotEncoder *e);
+void encoder_close(SnapshotEncoder *e);
+void encoder_log_stats(const SnapshotEncoder *e);
+
+WorldFrame *encoder_frame_begin(SnapshotEncoder *e);
+void encoder_frame_publish(SnapshotEncoder *e);
+
+void *encoder_thread(void *arg);
+
+#endif //SERPENT_ENCODER_H
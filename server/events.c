@@ -1,59 +1,302 @@
+#define _POSIX_C_SOURCE 200112L
 #include "events.h"
 #include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
 #include "logging.h"
+#include "timer.h"
 #include <assert.h>
+#include <errno.h>
+
+_Static_assert((MAX_EVENTS & (MAX_EVENTS - 1)) == 0, "MAX_EVENTS must be a power of two");
+
+#define EVENT_MASK ((size_t)MAX_EVENTS - 1)
+
+void batch_stats_record(BatchStats *s, const size_t n) {
+    s->drains++;
+    if (n == 0) return;
+    s->batches++;
+    s->items += n;
+    if (n > s->max_batch) s->max_batch = n;
+}
+
+void batch_stats_log(const BatchStats *s, const char *name) {
+    char buf[256];
+    const double avg = s->batches > 0 ? (double)s->items / (double)s->batches : 0.0;
+    snprintf(buf, sizeof buf, "%s queue stats: drains %zu, non-empty batches %zu, items %zu, "
+             "avg batch %.2f, max batch %zu\n", name, s->drains, s->batches, s->items, avg, s->max_batch);
+    log_server(buf);
+}
+
+void wait_stats_record(WaitStats *s, const uint64_t wait_ns) {
+    s->items++;
+    s->total_ns += wait_ns;
+    if (wait_ns > s->max_ns) s->max_ns = wait_ns;
+}
+
+void wait_stats_log(const WaitStats *s, const char *name) {
+    char buf[256];
+    const double avg_us = s->items > 0 ? (double)s->total_ns / (double)s->items / 1000.0 : 0.0;
+    snprintf(buf, sizeof buf, "%s time in queue: items %zu, avg %.1f us, max %.1f us\n",
+             name, s->items, avg_us, (double)s->max_ns / 1000.0);
+    log_server(buf);
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
 
 void event_queue_init(EventQueue *q) {
-    q->count = 0;
-    int rc = pthread_mutex_init(&q->lock, NULL);
-    if (rc != 0) {
-        log_server("FAILED: to init event queue mutex\n");
+    atomic_init(&q->head, 0);
+    q->tail = 0;
+    memset(&q->stats, 0, sizeof(q->stats));
+    for (size_t i = 0; i < MAX_EVENTS; ++i) {
+        atomic_init(&q->slots[i].seq, i); // slot i is free for position i
     }
-    rc = pthread_cond_init(&q->not_full, NULL);
-    if (rc != 0) {
+
+    atomic_init(&q->sleeping, false);
+    q->rung = false;
+    if (pthread_mutex_init(&q->bell_lock, NULL) != 0) {
         log_server("FAILED: to init event queue mutex\n");
     }
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (pthread_cond_init(&q->bell, &attr) != 0) {
+        log_server("FAILED: to init event queue cond\n");
+    }
+    pthread_condattr_destroy(&attr);
 }
 
 void event_queue_destroy(EventQueue *q) {
-    pthread_mutex_destroy(&q->lock);
-    pthread_cond_destroy(&q->not_full);
+    // ring is embedded and holds events by value, only the doorbell to release
+    pthread_mutex_destroy(&q->bell_lock);
+    pthread_cond_destroy(&q->bell);
+}
+
+// wakes the consumer if it sleeps in event_queue_wait, called after publishing
+static void event_queue_ring(EventQueue *q) {
+    // pairs with the fence in event_queue_wait: either the consumer sees the
+    // published slot or we see it sleeping
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!atomic_load_explicit(&q->sleeping, memory_order_relaxed)) return;
+
+    pthread_mutex_lock(&q->bell_lock);
+    q->rung = true;
+    pthread_cond_signal(&q->bell);
+    pthread_mutex_unlock(&q->bell_lock);
+}
+
+/**
+ * Attempts to append an event to the queue without blocking.
+ *
+ * Producers claim a position by advancing the shared head with a CAS and
+ * then publish the event by bumping the slot sequence number, so the
+ * consumer never observes a half written event.
+ *
+ * @param q   Pointer to the event queue.
+ * @param ev  Event to enqueue (copied by value).
+ * @return true if the event was enqueued, false if the queue is full.
+ */
+static bool try_enqueue_event(EventQueue *q, const Event *ev) {
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    EventSlot *slot;
+
+    while (true) {
+        slot = &q->slots[pos & EVENT_MASK];
+        const size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            // slot is free for this position, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+            // pos was reloaded by failed CAS
+        } else if (diff < 0) {
+            return false; // consumer has not released this slot yet -> full
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed); // another producer won, retry
+        }
+    }
+
+    slot->ev = *ev;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return true;
 }
 
 void enqueue_event(EventQueue *q, const Event ev) {
     assert(q != NULL);
-    pthread_mutex_lock(&q->lock);
-    if (q->count >= MAX_EVENTS) {
+    if (!try_enqueue_event(q, &ev)) {
         log_server("event queue full\n");
+        // main thread drains once per tick, back off instead of spinning on the head
+        while (!try_enqueue_event(q, &ev)) {
+            sleepn(1000L * 1000L); // 1 ms
+        }
     }
-    while (q->count >= MAX_EVENTS) {
-        pthread_cond_wait(&q->not_full, &q->lock);
+    event_queue_ring(q);
+}
+
+/**
+ * Attempts to append a batch of events with a single claim on the head.
+ *
+ * The whole range is reserved at once, which is possible when the slot for
+ * the last position is free: the consumer releases slots in order, so every
+ * slot before it is free as well.
+ *
+ * @return true if all events were enqueued, false if there is not enough room.
+ */
+static bool try_enqueue_events(EventQueue *q, const Event *evs, const size_t n) {
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    while (true) {
+        const EventSlot *last = &q->slots[(pos + n - 1) & EVENT_MASK];
+        const size_t seq = atomic_load_explicit(&last->seq, memory_order_acquire);
+        const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + n - 1);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + n,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
     }
-    q->events[q->count++] = ev;
-    pthread_mutex_unlock(&q->lock);
+
+    // publish in order so the consumer can start on the head of the batch
+    for (size_t i = 0; i < n; ++i) {
+        EventSlot *slot = &q->slots[(pos + i) & EVENT_MASK];
+        slot->ev = evs[i];
+        atomic_store_explicit(&slot->seq, pos + i + 1, memory_order_release);
+    }
+    return true;
 }
 
-bool dequeue_event(EventQueue *q, Event *ev) {
-    pthread_mutex_lock(&q->lock);
-    if (q->count == 0) {
-        pthread_mutex_unlock(&q->lock);
-        return false;
+/**
+ * Enqueues a batch of events in order.
+ *
+ * Used by the I/O reactor to push everything decoded in one wakeup with a
+ * single head claim. Falls back to per-event enqueue (which waits for room)
+ * when the batch does not fit.
+ *
+ * @param q    Pointer to the event queue.
+ * @param evs  Events to enqueue (copied by value).
+ * @param n    Number of events.
+ */
+void enqueue_events(EventQueue *q, const Event *evs, const size_t n) {
+    assert(q != NULL);
+    if (n == 0) return;
+    if (n <= MAX_EVENTS && try_enqueue_events(q, evs, n)) {
+        event_queue_ring(q);
+        return;
     }
-    *ev = q->events[0];
 
-    // shift remaining events
-    for (size_t i = 1; i < q->count; ++i) {
-        q->events[i - 1] = q->events[i];
+    for (size_t i = 0; i < n; ++i) {
+        enqueue_event(q, evs[i]);
     }
-    q->count--;
-    pthread_cond_signal(&q->not_full);
-    pthread_mutex_unlock(&q->lock);
+}
+
+// single consumer only (main thread)
+bool dequeue_event(EventQueue *q, Event *ev) {
+    EventSlot *slot = &q->slots[q->tail & EVENT_MASK];
+    const size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+    if (seq != q->tail + 1) {
+        return false; // empty or producer still writing
+    }
+
+    *ev = slot->ev;
+    // release slot for the producer that wraps around to it
+    atomic_store_explicit(&slot->seq, q->tail + MAX_EVENTS, memory_order_release);
+    q->tail++;
     return true;
 }
 
+/**
+ * Pops up to max events in FIFO order in a single pass over the ring.
+ *
+ * Intended to be called once per tick by the consumer (main thread) so the
+ * whole pending batch is taken at once. Only events that are fully published
+ * are returned, the rest stay for the next drain.
+ *
+ * @param q    Pointer to the event queue.
+ * @param buf  Destination buffer with room for at least max events.
+ * @param max  Maximum number of events to drain.
+ * @return Number of events written to buf.
+ */
+size_t drain_events(EventQueue *q, Event *buf, const size_t max) {
+    size_t n = 0;
+    while (n < max && dequeue_event(q, &buf[n])) {
+        n++;
+    }
+    batch_stats_record(&q->stats, n);
+    return n;
+}
+
+// single consumer only: whether the next event is fully published
+static bool event_queue_ready(EventQueue *q) {
+    const EventSlot *slot = &q->slots[q->tail & EVENT_MASK];
+    return atomic_load_explicit(&slot->seq, memory_order_acquire) == q->tail + 1;
+}
+
+/**
+ * Blocks the consumer until an event is published or the deadline passes.
+ *
+ * For the idle game loop: instead of ticking while nothing can change it
+ * sleeps here, and any producer wakes it right away. Returns immediately
+ * if events are already queued.
+ *
+ * @param q         Pointer to the event queue.
+ * @param deadline  Absolute CLOCK_MONOTONIC time to give up at, NULL to wait without limit.
+ * @return true if events are ready to drain, false on timeout.
+ */
+bool event_queue_wait(EventQueue *q, const struct timespec *deadline) {
+    pthread_mutex_lock(&q->bell_lock);
+    atomic_store_explicit(&q->sleeping, true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    while (!event_queue_ready(q) && !q->rung) {
+        const int rc = deadline ? pthread_cond_timedwait(&q->bell, &q->bell_lock, deadline)
+                                : pthread_cond_wait(&q->bell, &q->bell_lock);
+        if (rc == ETIMEDOUT) break;
+    }
+
+    atomic_store_explicit(&q->sleeping, false, memory_order_relaxed);
+    q->rung = false;
+    pthread_mutex_unlock(&q->bell_lock);
+    return event_queue_ready(q);
+}
+
+
+ActionClass action_class(const ActionType type) {
+    switch (type) {
+        case ACT_SEND_GAME_STATE:
+            return ACT_CLASS_BULK;
+        default:
+            return ACT_CLASS_CONTROL;
+    }
+}
 
 void action_queue_init(ActionQueue *q) {
-    q->count = 0;
+    for (size_t i = 0; i < ACT_CLASS_COUNT; ++i) {
+        ActionLane *lane = &q->lanes[i];
+        lane->pending = lane->buffers[0];
+        lane->count = 0;
+        lane->retired = lane->buffers[1];
+        lane->retired_head = 0;
+        lane->retired_count = 0;
+        memset(&lane->wait, 0, sizeof(lane->wait));
+    }
+    q->closed = false;
+    memset(&q->stats, 0, sizeof(q->stats));
     int rc = pthread_mutex_init(&q->lock, NULL);
     if (rc != 0) {
         log_server("FAILED: to init action queue mutex\n");
@@ -62,39 +305,144 @@ void action_queue_init(ActionQueue *q) {
     if (rc != 0) {
         log_server("FAILED: to init action queue mutex\n");
     }
+    rc = pthread_cond_init(&q->not_empty, NULL);
+    if (rc != 0) {
+        log_server("FAILED: to init action queue cond\n");
+    }
 }
 
 void action_queue_destroy(ActionQueue *q) {
     pthread_mutex_destroy(&q->lock);
     pthread_cond_destroy(&q->not_full);
+    pthread_cond_destroy(&q->not_empty);
 }
 
-void enqueue_action(ActionQueue *q, const Action act) {
+// wakes up the worker blocked in action_queue_wait so it can observe shutdown
+void action_queue_close(ActionQueue *q) {
     pthread_mutex_lock(&q->lock);
-    if (q->count >= MAX_ACTIONS) {
+    q->closed = true;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+void action_queue_log_stats(const ActionQueue *q) {
+    batch_stats_log(&q->stats, "action");
+    wait_stats_log(&q->lanes[ACT_CLASS_CONTROL].wait, "control action");
+    wait_stats_log(&q->lanes[ACT_CLASS_BULK].wait, "bulk action");
+}
+
+void enqueue_action(ActionQueue *q, Action act) {
+    act.enqueued_ns = monotonic_ns();
+    ActionLane *lane = &q->lanes[action_class(act.type)];
+
+    pthread_mutex_lock(&q->lock);
+    if (lane->count >= MAX_ACTIONS) {
         log_server("action queue full\n");
     }
-    while (q->count >= MAX_ACTIONS) {
+    while (lane->count >= MAX_ACTIONS) {
         pthread_cond_wait(&q->not_full, &q->lock);
     }
-    q->actions[q->count++] = act;
+    lane->pending[lane->count++] = act;
+    pthread_cond_signal(&q->not_empty);
     pthread_mutex_unlock(&q->lock);
 }
 
 bool dequeue_action(ActionQueue *q, Action *act) {
+    return drain_actions(q, act, 1) == 1;
+}
+
+// worker only: actions still to be handed out without taking the lock
+static size_t lane_retired_left(const ActionLane *lane) {
+    return lane->retired_count - lane->retired_head;
+}
+
+/**
+ * Blocks until the action queue holds at least one action or is closed.
+ *
+ * Lets the worker sleep with no CPU use while idle and wake up as soon as
+ * an action is enqueued instead of polling on a fixed interval.
+ *
+ * @param q  Pointer to the action queue.
+ * @return true if actions are pending, false if the queue was closed and is empty.
+ */
+bool action_queue_wait(ActionQueue *q) {
+    for (size_t i = 0; i < ACT_CLASS_COUNT; ++i) {
+        if (lane_retired_left(&q->lanes[i]) > 0) return true;
+    }
+
     pthread_mutex_lock(&q->lock);
-    if (q->count == 0) {
+    while (q->lanes[ACT_CLASS_CONTROL].count == 0 && q->lanes[ACT_CLASS_BULK].count == 0 && !q->closed) {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+    const bool pending = q->lanes[ACT_CLASS_CONTROL].count > 0 || q->lanes[ACT_CLASS_BULK].count > 0;
+    pthread_mutex_unlock(&q->lock);
+    return pending;
+}
+
+/**
+ * Hands out up to max actions of one lane.
+ *
+ * When the retired batch is used up, it is swapped with the pending buffer
+ * under a single lock acquisition, so producers continue into an empty
+ * buffer and the batch is copied out with the lock released. Only one
+ * thread (worker) may drain, which is what keeps the retired buffer
+ * untouched until the next swap.
+ *
+ * @return Number of actions written to buf.
+ */
+static size_t lane_take(ActionQueue *q, ActionLane *lane, Action *buf, const size_t max, const uint64_t now_ns) {
+    if (lane_retired_left(lane) == 0) {
+        pthread_mutex_lock(&q->lock);
+        if (lane->count > 0) {
+            const Action *batch = lane->pending;
+            lane->pending = (Action *)lane->retired;
+            lane->retired = batch;
+            lane->retired_head = 0;
+            lane->retired_count = lane->count;
+            lane->count = 0;
+            pthread_cond_broadcast(&q->not_full);
+        }
         pthread_mutex_unlock(&q->lock);
-        return false;
     }
-    *act = q->actions[0];
 
-    // shift remaining actions
-    for (size_t i = 1; i < q->count; ++i) {
-        q->actions[i - 1] = q->actions[i];
+    const size_t left = lane_retired_left(lane);
+    const size_t n = left < max ? left : max;
+    memcpy(buf, lane->retired + lane->retired_head, n * sizeof(Action));
+    lane->retired_head += n;
+
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t queued = buf[i].enqueued_ns;
+        wait_stats_record(&lane->wait, now_ns > queued ? now_ns - queued : 0);
     }
-    q->count--;
-    pthread_cond_signal(&q->not_full);
-    pthread_mutex_unlock(&q->lock);
-    return true;
-}
\ No newline at end of file
+    return n;
+}
+
+/**
+ * Takes the next batch of actions for the worker, control actions first.
+ *
+ * All queued control actions (up to max) are returned before any bulk
+ * action. Bulk actions are only handed out when no control action is
+ * waiting, at most MAX_BULK_BATCH at a time, so a control action enqueued
+ * during a tick's snapshot sends waits for one chunk rather than the
+ * whole tick. Order within a class is FIFO.
+ *
+ * @param q    Pointer to the action queue.
+ * @param buf  Destination buffer with room for at least max actions.
+ * @param max  Maximum number of actions to drain.
+ * @return Number of actions written to buf.
+ */
+size_t drain_actions(ActionQueue *q, Action *buf, const size_t max) {
+    const uint64_t now_ns = monotonic_ns();
+
+    size_t n = lane_take(q, &q->lanes[ACT_CLASS_CONTROL], buf, max, now_ns);
+    if (n < max && lane_retired_left(&q->lanes[ACT_CLASS_CONTROL]) == 0) {
+        // retired remainder used up, also take control actions queued since the last swap
+        n += lane_take(q, &q->lanes[ACT_CLASS_CONTROL], buf + n, max - n, now_ns);
+    }
+    if (n == 0) {
+        n = lane_take(q, &q->lanes[ACT_CLASS_BULK], buf, max < MAX_BULK_BATCH ? max : MAX_BULK_BATCH, now_ns);
+    }
+
+    batch_stats_record(&q->stats, n);
+    return n;
+}
@@ -3,30 +3,34 @@
 #include <pthread.h>
 #include "config.h"
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <types.h>
+#include "handles.h"
+#include "protocol.h"
 
 
 // events from worker or other input thread to main thread
 // sort of response (something has happened)
 typedef enum {
-    EV_CONNECTED, // worker signals new player connected needs add new player to game state : main handles ... player id
+    EV_CONNECTED, // worker signals new player connected needs add new player to game state : main handles ... player handle
     EV_LOADED, // worker signals world loaded : main handles. ... no params
     EV_INPUT, // input thread signals input received : main handles ... EvArgInput
-    EV_PAUSED, // input thread signals pause clicked : main handles ... player id
-    EV_RESUMED, // input thread signals resume clicked : main handles ... player id
-    EV_WAITED_AFTER_RESUME, // player id
-    EV_DISCONNECTED, // input thread signals player disconnected : main handles ... player id
-    EV_WAITED_FOR_GAME_OVER, // worker signals wait time over : main handles (send game over) ... no params
+    EV_PAUSED, // input thread signals pause clicked : main handles ... player handle
+    EV_RESUMED, // input thread signals resume clicked : main handles ... player handle
+    EV_WAITED_AFTER_RESUME, // timer wheel signals resume delay over : main handles ... player handle
+    EV_DISCONNECTED, // input thread signals player disconnected : main handles ... player handle
+    EV_WAITED_FOR_GAME_OVER, // timer wheel signals wait time over : main handles (send game over) ... no params
     EV_ERROR, // worker signals error occurred : main handles (send_error_msg) ... EvArgErrorMessage
 } EventType;
 
 typedef struct {
-    int player_id;
+    PlayerHandle player;
     Direction direction;
 } EvArgInput;
 
 typedef struct {
-    int player_id;
+    PlayerHandle player;
     const char *error_msg;
 } EvArgErrorMessage;
 
@@ -34,75 +38,149 @@ typedef struct {
     EventType type;
     union {
         int         nodata;
-        int         player_id;
+        PlayerHandle player;
         EvArgInput  input;
         EvArgErrorMessage error;
     } u;
 } Event;
 
+// batch statistics kept by the consumer of a queue (single thread, no locking)
+typedef struct {
+    size_t drains; // number of drain calls (one per tick for events)
+    size_t batches; // drains that returned at least one item (lock acquisitions for actions)
+    size_t items; // total items drained (lock acquisitions a per-item pop would need)
+    size_t max_batch;
+} BatchStats;
+
+void batch_stats_record(BatchStats *s, size_t n);
+void batch_stats_log(const BatchStats *s, const char *name);
+
+// time items spent queued, kept by the consumer (single thread, no locking)
+typedef struct {
+    size_t items;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} WaitStats;
+
+void wait_stats_record(WaitStats *s, uint64_t wait_ns);
+void wait_stats_log(const WaitStats *s, const char *name);
+
 // event queue
+// bounded lock-free multi-producer/single-consumer ring (many input threads -> main thread)
+// each slot carries a sequence number telling whether it is free for position `pos` (seq == pos)
+// or already holds the event for `pos` (seq == pos + 1)
 typedef struct {
-    Event events[MAX_EVENTS];
-    size_t count;
-    pthread_mutex_t lock;
-    pthread_cond_t not_full;
+    _Atomic size_t seq;
+    Event ev;
+} EventSlot;
+
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t head; // next position to claim, shared by producers
+    _Alignas(CACHE_LINE_SIZE) size_t tail; // next position to read, owned by the single consumer
+    BatchStats stats; // consumer side only
+    _Alignas(CACHE_LINE_SIZE) EventSlot slots[MAX_EVENTS];
+
+    // doorbell for a consumer that sleeps in event_queue_wait, producers only
+    // take the lock when `sleeping` is set, so the ring stays lock-free while ticking
+    _Alignas(CACHE_LINE_SIZE) _Atomic bool sleeping;
+    bool rung;
+    pthread_mutex_t bell_lock;
+    pthread_cond_t bell; // CLOCK_MONOTONIC, deadlines are absolute
 } EventQueue;
 
 void event_queue_init(EventQueue *q);
 void event_queue_destroy(EventQueue *q);
 void enqueue_event(EventQueue *q, Event ev);
+void enqueue_events(EventQueue *q, const Event *evs, size_t n);
 bool dequeue_event(EventQueue *q, Event *ev);
+size_t drain_events(EventQueue *q, Event *buf, size_t max);
+bool event_queue_wait(EventQueue *q, const struct timespec *deadline);
 
 // commands from main thread to worker (worker may respond with events)
 typedef enum {
     ACT_LOAD_WORLD, // main -> worker: response event EV_LOADED
-    ACT_SEND_READY, // (worker sends EV_CONNECTED) main -> worker: send msg ready, player id param
-    ACT_SEND_GAME_OVER, // send msg game over, player id param only (game state is expected to send updates)
+    ACT_SEND_READY, // (worker sends EV_CONNECTED) main -> worker: send msg ready, ActArgReady param
+    ACT_SEND_GAME_OVER, // send msg game over with the player's final result, ActArgGameOver param
     ACT_SEND_GAME_STATE, // ActArgGameState param
-    ACT_UNREGISTER_PLAYER, // player id param
-    ACT_WAIT_FOR_END, // end in seconds param
-    ACT_WAIT_PAUSED, // ActArgPlayerWait
+    ACT_UNREGISTER_PLAYER, // player handle param
     ACT_SEND_ERROR, // ActArgErrorMessage
 } ActionType;
 
 typedef struct {
-    int player_id;
-    int seconds;
-} ActArgPlayerWait;
-
-typedef struct {
-    int player_id;
-    ClientGameStateSnapshot *state; // dynamically allocated snapshot, ownership transfer main thread -> worker (so worker frees it)
+    PlayerHandle player;
+    Message msg; // encoded MSG_STATE, payload ownership transfer encoder -> worker (worker queues it to client)
 } ActArgGameState;
 
 typedef struct {
-    int player_id;
+    PlayerHandle player;
     const char *error_msg;
 } ActArgErrorMessage;
 
+typedef struct {
+    PlayerHandle player;
+    uint32_t tick_rate;
+} ActArgReady;
+
+// final result travels with the game over itself, snapshots queued before it may never arrive
+typedef struct {
+    PlayerHandle player;
+    uint32_t score;
+    uint32_t time_elapsed; // seconds in game
+} ActArgGameOver;
+
 typedef struct {
     ActionType type;
+    uint64_t enqueued_ns; // CLOCK_MONOTONIC, set by enqueue_action (time-in-queue stats)
     union {
-        int                 player_id;
-        int                 end_in_seconds;
-        ActArgPlayerWait    wait;
+        PlayerHandle        player;
         ActArgGameState     game;
         ActArgErrorMessage  error;
+        ActArgReady         ready;
+        ActArgGameOver      over;
     } u;
 } Action;
 
+// priority classes of actions, lower value is dequeued first
+typedef enum {
+    ACT_CLASS_CONTROL, // ready, game over, unregister, errors ... latency sensitive
+    ACT_CLASS_BULK, // game state snapshots, one per player per tick
+    ACT_CLASS_COUNT,
+} ActionClass;
+
+ActionClass action_class(ActionType type);
+
+// one lane per class
+// double-buffered: producers append to `pending` while the worker processes the
+// other buffer (`retired`), the two are swapped under the lock once retired is used up
+typedef struct {
+    Action buffers[2][MAX_ACTIONS];
+    Action *pending; // buffer producers append to, points into buffers
+    size_t count; // number of actions in pending
+    const Action *retired; // swapped out batch, worker only
+    size_t retired_head; // next action of retired to hand out
+    size_t retired_count;
+    WaitStats wait; // time in queue, consumer side only
+} ActionLane;
 
 // action queue
+// control lane is always dequeued before bulk lane, bulk is handed out in chunks of
+// MAX_BULK_BATCH so newly queued control actions never wait behind a whole tick of snapshots
 typedef struct {
-    Action actions[MAX_ACTIONS];
-    size_t count;
+    ActionLane lanes[ACT_CLASS_COUNT];
+    bool closed; // set on shutdown so a waiting worker returns
     pthread_mutex_t lock;
     pthread_cond_t not_full;
+    pthread_cond_t not_empty; // signalled on every enqueue so the worker wakes immediately
+    BatchStats stats; // consumer side only
 } ActionQueue;
 
 void action_queue_init(ActionQueue *q);
 void action_queue_destroy(ActionQueue *q);
+void action_queue_close(ActionQueue *q);
+void action_queue_log_stats(const ActionQueue *q);
 void enqueue_action(ActionQueue *q, Action act);
 bool dequeue_action(ActionQueue *q, Action *act);
+size_t drain_actions(ActionQueue *q, Action *buf, size_t max);
+bool action_queue_wait(ActionQueue *q);
 
 #endif //SERPENT_EVENTS_H
\ No newline at end of file
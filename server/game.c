@@ -1,25 +1,111 @@
+#define _POSIX_C_SOURCE 199309L
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include "config.h"
 #include "game.h"
 #include "server.h"
 #include "logging.h"
 
-void game_init(GameState *game, const int width, const int height, const int game_time,
-               const bool obstacles_enabled, const bool random_world, const char *file_path) {
+void game_options_init(GameOptions *o) {
+    o->tick_rate = GAME_TICK_RATE;
+    o->adaptive_snapshots = false;
+    o->head_clearance = SPAWN_HEAD_CLEARANCE;
+}
+
+/**
+ * Parses one `--` command line option into the game options.
+ *
+ * @param o    Pointer to the options.
+ * @param arg  Argument starting with "--".
+ * @return 1 if consumed, 0 if not a known option, -1 if its value is invalid.
+ */
+int game_parse_option(GameOptions *o, const char *arg) {
+    const char *eq = strchr(arg, '=');
+    const char *value = eq ? eq + 1 : NULL;
+    const size_t name_len = eq ? (size_t)(eq - arg) : strlen(arg);
+
+    if (name_len == strlen("--tick-rate") && strncmp(arg, "--tick-rate", name_len) == 0) {
+        char *end = NULL;
+        const long rate = value ? strtol(value, &end, 10) : -1;
+        if (!value || *end != '\0' || rate < 1 || rate > MAX_TICK_RATE) return -1;
+        o->tick_rate = (int)rate;
+        return 1;
+    }
+    if (strcmp(arg, "--adaptive-snapshots") == 0) {
+        o->adaptive_snapshots = true;
+        return 1;
+    }
+    if (name_len == strlen("--head-clearance") && strncmp(arg, "--head-clearance", name_len) == 0) {
+        char *end = NULL;
+        const long cells = value ? strtol(value, &end, 10) : -1;
+        if (!value || *end != '\0' || cells < 0 || cells > MAX_SPAWN_HEAD_CLEARANCE) return -1;
+        o->head_clearance = (int)cells;
+        return 1;
+    }
+    return 0;
+}
+
+void game_usage(const char *prog) {
+    fprintf(stderr, "Game options for %s (may appear anywhere):\n"
+                    "  --tick-rate=N       game updates per second 1-%d (default %d)\n"
+                    "  --adaptive-snapshots  send fewer snapshots when ticks run close to their budget\n"
+                    "  --head-clearance=N  cells between a joining snake and live heads 0-%d (default %d)\n",
+            prog, MAX_TICK_RATE, GAME_TICK_RATE, MAX_SPAWN_HEAD_CLEARANCE, SPAWN_HEAD_CLEARANCE);
+}
+
+/**
+ * Sets up the game state and builds the world.
+ *
+ * @return 0 on success, -1 if the world or the player and body pools could not be
+ *         allocated (nothing is left to destroy then).
+ */
+int game_init(GameState *game, const int width, const int height, const int game_time,
+              const bool obstacles_enabled, const bool random_world, const char *file_path,
+              const GameOptions *opts) {
+    memset(game, 0, sizeof(*game)); // every failure path below may hand a partly built state to game_destroy
     game->width = width;
     game->height = height;
+    if (grid_init(&game->grid, width, height) < 0) {
+        return -1; // every tick would look cells up in it
+    }
 
     game->wait_for_end_pending = false;
+    timer_wheel_init(&game->timers);
+    game->tick_rate = opts->tick_rate;
+    game->head_clearance = opts->head_clearance;
+    tick_clock_init(&game->clock, 1000000000LL / opts->tick_rate, TICK_SKIP);
+    snapshot_rate_init(&game->snapshots, opts->adaptive_snapshots, 1000000000LL / opts->tick_rate);
+    tick_jitter_init(&game->jitter);
+    game->idle = false;
+    game->idle_waits = 0;
+    game->idle_ns = 0;
 
-    game->players = NULL;
-    game->player_count = 0;
-
-    game->fruits = NULL;
     game->fruit_count = 0;
 
     game->obstacles = NULL;
     game->obstacle_count = 0;
 
+    // a join takes its player slot, first body and fruit from these without touching the heap
+    body_pool_init(&game->bodies);
+    game->fruits = malloc(FRUIT_CAPACITY * sizeof(Fruit));
+    if (!game->fruits) log_server("FAILED: to allocate fruits\n");
+    if (!game->fruits || player_pool_init(&game->players) < 0) {
+        game_destroy(game);
+        return -1;
+    }
+    // every joining snake starts on a body of the initial capacity, have one ready per slot
+    size_t initial_capacity = 1;
+    while (initial_capacity < INITIAL_SNAKE_LENGTH) initial_capacity <<= 1;
+    if (body_pool_reserve(&game->bodies, initial_capacity, MAX_PLAYERS) < 0) {
+        log_server("FAILED: to reserve snake bodies\n");
+        game_destroy(game);
+        return -1;
+    }
+    for (size_t i = 0; i < MAX_PLAYERS; ++i) {
+        game->player_index[i] = -1;
+    }
+
     Timer timer;
     timer_reset(&timer);
     game->timer = timer;
@@ -37,36 +123,112 @@ void game_init(GameState *game, const int width, const int height, const int gam
             game_spawn_obstacles_from_file(game, file_path);
         }
     }
+    return 0;
 }
 
-void game_destroy(const GameState *game) {
-    if (game->players != NULL) {
-        for (size_t i = 0; i < game->player_count; ++i) {
-            free(game->players[i].snake.body);
+void game_destroy(GameState *game) {
+    if (game->players.slots != NULL) {
+        for (size_t i = 0; i < game->players.count; ++i) {
+            snake_destroy(&player_pool_at(&game->players, i)->snake, &game->bodies); // noop if already dropped
         }
     }
-    free(game->players);
+    player_pool_destroy(&game->players);
+    body_pool_destroy(&game->bodies);
     free(game->fruits);
     free(game->obstacles); // free is noop on NULL so its ok
+    grid_destroy(&game->grid);
+    timer_wheel_destroy(&game->timers);
 }
 
-void game_run(GameState *game, const bool timed_mode, const bool single_player, const bool easy_mode,
-    EventQueue *eq, ActionQueue *aq, ClientRegistry *reg) {
+// true when no snake can move: nobody in game or everyone paused (also covers waiting for end)
+bool game_quiescent(const GameState *game) {
+    for (size_t i = 0; i < game->players.count; ++i) {
+        if (!player_pool_at(&game->players, i)->paused) return false;
+    }
+    return true;
+}
+
+/**
+ * Decides whether this tick sends a snapshot.
+ *
+ * While the game is active the snapshot rate decides. Once it goes idle
+ * one snapshot shows the settled state and after that the world only
+ * changes through events, so apart from ticks that handled some only a
+ * heartbeat every IDLE_HEARTBEAT_MS keeps the clocks on the clients moving.
+ *
+ * @param game     Pointer to the game state.
+ * @param idle     Whether the game is quiescent at the end of this tick.
+ * @param handled  Whether this tick handled events or fired timers.
+ * @return true if a snapshot should be published.
+ */
+static bool game_snapshot_due(GameState *game, const bool idle, const bool handled) {
+    const bool was_idle = game->idle;
+    game->idle = idle;
+    if (!idle) return snapshot_rate_due(&game->snapshots);
+
+    const struct timespec *now = tick_clock_now(&game->clock);
+    if (was_idle && !handled && timespec_before(now, &game->heartbeat_at)) return false;
+
+    game->heartbeat_at = timespec_add_ms(*now, IDLE_HEARTBEAT_MS);
+    return true;
+}
+
+/**
+ * Sleeps while the game is quiescent instead of running empty ticks.
+ *
+ * Wakes up on the first queued event (input, resume, connect, disconnect),
+ * the earliest pending timer, the idle heartbeat or the end of a timed game,
+ * whichever comes first. The tick schedule restarts from the wakeup so a
+ * resumed player is handled on the very next tick.
+ *
+ * @param game        Pointer to the game state.
+ * @param eq          Event queue to wait on.
+ * @param timed_mode  Whether the game ends when its timer runs out.
+ */
+static void game_idle_wait(GameState *game, EventQueue *eq, const bool timed_mode) {
+    struct timespec wake = game->heartbeat_at;
+    struct timespec at;
+    if (timer_wheel_next_expiry(&game->timers, &at) && timespec_before(&at, &wake)) wake = at;
+    if (timed_mode) {
+        const double remaining = timer_remaining_at(&game->timer, tick_clock_now(&game->clock));
+        at = timespec_add_ms(*tick_clock_now(&game->clock), remaining > 0 ? (long)(remaining * 1000.0) : 0);
+        if (timespec_before(&at, &wake)) wake = at;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!timespec_before(&start, &wake)) return; // already due, keep ticking
 
-    // timeout loop - waiting for at least one player to connect
-    Timer timeout_timer;
-    timer_reset(&timeout_timer);
-    timer_set(&timeout_timer, 10); // 10 sec timeout for connection to avoid race condition with recv thread
-    timer_start(&timeout_timer);
+    event_queue_wait(eq, &wake);
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    game->idle_waits++;
+    game->idle_ns += (int64_t)(end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+    tick_clock_resync(&game->clock);
+    timer_wheel_advance(&game->timers, &end); // timers scheduled by the waking event count from now
+}
+
+void game_run(GameState *game, const bool timed_mode, const bool single_player, const bool easy_mode,
+    EventQueue *eq, ActionQueue *aq, ClientRegistry *reg, SnapshotEncoder *enc) {
+
+    // timeout loop - waiting for at least one player to connect, asleep until an event arrives
+    struct timespec timeout_at;
+    clock_gettime(CLOCK_MONOTONIC, &timeout_at);
+    timeout_at = timespec_add_ms(timeout_at, FIRST_PLAYER_TIMEOUT_MS); // avoids race condition with recv thread
+    static Event batch[MAX_EVENTS]; // tick thread only, kept off the stack
+    size_t n;
     while (true) {
+        const bool ready = event_queue_wait(eq, &timeout_at);
+
         // handle events (only EVENT_CONNECTED is relevant)
-        Event ev = {0};
-        while (dequeue_event(eq, &ev)) {
-            handle_event(&ev, aq, game);
+        n = drain_events(eq, batch, MAX_EVENTS);
+        for (size_t i = 0; i < n; ++i) {
+            handle_event(&batch[i], aq, game);
         }
 
-        if (game->player_count > 0) break; // at least one player connected
-        if (timer_expired(&timeout_timer)) {
+        if (game->players.count > 0) break; // at least one player connected
+        if (!ready) {
             log_server("timeout waiting for first player connection\n");
 
             broadcast_error(reg, "Timeout waiting for first player connection\n");
@@ -74,104 +236,146 @@ void game_run(GameState *game, const bool timed_mode, const bool single_player,
         }
     }
 
-    // game loop
+    // game loop, ticks on absolute deadlines; a late tick drops the missed ones instead of bursting moves
     timer_start(&game->timer);
+    tick_clock_init(&game->clock, 1000000000LL / game->tick_rate, TICK_SKIP);
     while (true) {
-
-        game_broadcast_snapshot(game, aq);
-
-        sleep_frame(GAME_TICK_TIME_MS);
+        const struct timespec *now = tick_clock_wait(&game->clock);
+        tick_jitter_record(&game->jitter, game->clock.late_ns);
 
         game_update(game, easy_mode, aq);
 
-        // handle events
-        Event ev = {0};
+        // handle events, whole batch taken at once per tick
         bool end_game = false;
-        while (dequeue_event(eq, &ev)) {
-            end_game = handle_event(&ev, aq, game);
+        n = drain_events(eq, batch, MAX_EVENTS);
+        for (size_t i = 0; i < n; ++i) {
+            end_game |= handle_event(&batch[i], aq, game); // a later event must not cancel the end
         }
         if (end_game) break;
 
-        end_game = handle_end_event(timed_mode, single_player, game, aq);
+        // fire due timers on this tick
+        Event ev;
+        bool handled = n > 0;
+        timer_wheel_advance(&game->timers, now);
+        while (timer_wheel_pop_expired(&game->timers, &ev)) {
+            end_game |= handle_event(&ev, aq, game);
+            handled = true;
+        }
+        if (end_game) break;
+
+        // hand the finished tick to the encoder thread, it serializes while the next tick runs
+        const bool idle = game_quiescent(game);
+        const bool snapshot = game_snapshot_due(game, idle, handled);
+        if (snapshot) game_publish_frame(game, enc);
+
+        snapshot_rate_record(&game->snapshots, tick_clock_elapsed_ns(&game->clock), idle, snapshot);
+
+        end_game = handle_end_event(timed_mode, single_player, game);
 
         if (end_game) break;
 
+        if (idle) game_idle_wait(game, eq, timed_mode);
     }
 
-    broadcast_game_over(reg); // must be done here before shutdown so we are sure all clients get it (its blocking)
+    char buf[128];
+    snprintf(buf, sizeof buf, "idle: slept %llu times, %.1f s in total\n",
+             (unsigned long long)game->idle_waits, (double)game->idle_ns / 1e9);
+    log_server(buf);
+
+    broadcast_game_over(reg, game); // must be done here before shutdown so we are sure all clients get it (flushed on registry destroy)
     log_server("game over broadcasted to clients\n");
 }
 
-void game_broadcast_snapshot(const GameState *game, ActionQueue *aq) {
-
-    // for each client
-    for (size_t i = 0; i < game->player_count; ++i) {
-        Action act;
-        act.type = ACT_SEND_GAME_STATE;
-
-        ClientGameStateSnapshot *snapshot = malloc(sizeof(*snapshot));
-        if (!snapshot) {
-            // TODO handle OOM as needed
-            continue;
-        }
-
-        snapshot->width = game->width;
-        snapshot->height = game->height;
-
-        snapshot->score = game->players[i].score;
-        snapshot->player_time_elapsed = (int)timer_elapsed(&game->players[i].timer);
-        snapshot->game_time_remaining = (int)timer_remaining(&game->timer);
-
-        snapshot->snake_count = game->player_count;
-        snapshot->snakes = malloc(snapshot->snake_count * sizeof(SnakeSnapshot));
-        for (size_t j = 0; j < game->player_count; ++j) {
-            const Player *p = &game->players[j];
-            SnakeSnapshot *ss = &snapshot->snakes[j];
-            ss->length = p->snake.length;
-            ss->body = malloc(ss->length * sizeof(Position));
-            for (size_t k = 0; k < ss->length; ++k) {
-                ss->body[k] = p->snake.body[k];
-            }
-        }
+// grows a frame array with headroom, so snakes growing by one cell do not realloc every tick
+static int reserve_frame(void **items, size_t *capacity, const size_t n, const size_t item_size) {
+    if (n <= *capacity) return 0;
+    return reserve_items(items, capacity, n + n / 2, item_size);
+}
 
-        snapshot->fruit_count = game->fruit_count;
-        snapshot->fruits = malloc(snapshot->fruit_count * sizeof(Fruit));
-        for (size_t j = 0; j < game->fruit_count; ++j) {
-            snapshot->fruits[j] = game->fruits[j];
-        }
+/**
+ * Copies the end-of-tick world into the encoder's back frame and publishes it.
+ *
+ * Only plain copies into arrays the frame keeps between ticks, the
+ * serialization and per-player messages are left to the encoder thread
+ * while the next tick simulates.
+ *
+ * @param game  Pointer to the game state, read only.
+ * @param enc   Pointer to the snapshot encoder.
+ */
+void game_publish_frame(const GameState *game, SnapshotEncoder *enc) {
+    WorldFrame *f = encoder_frame_begin(enc);
+    const struct timespec *now = tick_clock_now(&game->clock);
+
+    size_t body_count = 0;
+    for (size_t i = 0; i < game->players.count; ++i) {
+        body_count += player_pool_at(&game->players, i)->snake.length;
+    }
 
-        snapshot->obstacle_count = game->obstacle_count;
-        snapshot->obstacles = malloc(snapshot->obstacle_count * sizeof(Obstacle));
-        for (size_t j = 0; j < game->obstacle_count; ++j) {
-            snapshot->obstacles[j] = game->obstacles[j];
-        }
+    if (reserve_frame((void **)&f->players, &f->player_capacity, game->players.count, sizeof(FramePlayer)) < 0 ||
+        reserve_frame((void **)&f->bodies, &f->body_capacity, body_count, sizeof(Position)) < 0 ||
+        reserve_frame((void **)&f->fruits, &f->fruit_capacity, game->fruit_count, sizeof(Fruit)) < 0 ||
+        reserve_frame((void **)&f->obstacles, &f->obstacle_capacity, game->obstacle_count, sizeof(Obstacle)) < 0) {
+        log_server("FAILED: to allocate world frame, snapshot skipped\n");
+        return;
+    }
 
-        if (!snapshot->snakes || !snapshot->fruits || !snapshot->obstacles) {
-            snapshot_destroy(snapshot);
-            free(snapshot);
-            continue;
-        }
+    f->tick = game->clock.ticks;
+    f->width = game->width;
+    f->height = game->height;
+    f->game_time_remaining = (int)timer_remaining_at(&game->timer, now);
+
+    size_t at = 0;
+    for (size_t i = 0; i < game->players.count; ++i) {
+        const Player *p = player_pool_at(&game->players, i);
+        f->players[i] = (FramePlayer){
+            .handle = p->handle,
+            .score = (uint32_t)p->score,
+            .time_elapsed = (uint32_t)timer_elapsed_at(&p->timer, now),
+            .body_start = at,
+            .length = p->snake.length,
+        };
+        snake_copy_body(&p->snake, &f->bodies[at]);
+        at += p->snake.length;
+    }
+    f->player_count = game->players.count;
+    f->body_count = body_count;
 
-        act.u.game.state = snapshot;      // pointer, no copy
-        act.u.game.player_id = game->players[i].id;
+    memcpy(f->fruits, game->fruits, game->fruit_count * sizeof(Fruit));
+    f->fruit_count = game->fruit_count;
+    memcpy(f->obstacles, game->obstacles, game->obstacle_count * sizeof(Obstacle));
+    f->obstacle_count = game->obstacle_count;
 
-        enqueue_action(aq, act);
+    encoder_frame_publish(enc);
+}
 
-    }
+// final result of a player leaving the game now, sent with its game over
+static ActArgGameOver player_result(const GameState *game, const Player *p) {
+    return (ActArgGameOver){
+        .player = p->handle,
+        .score = (uint32_t)p->score,
+        .time_elapsed = (uint32_t)timer_elapsed_at(&p->timer, tick_clock_now(&game->clock)),
+    };
 }
 
-int broadcast_game_over(ClientRegistry *reg) {
+// messages are only queued (non-blocking), registry flushes leftovers on shutdown
+// players still in game get their final result, other clients a bare game over
+int broadcast_game_over(ClientRegistry *reg, const GameState *game) {
 
     int rc = 0;
-    pthread_mutex_lock(&reg->lock);
-    for (size_t i = 0; i < reg->count; ++i) {
-        if (send_game_over(reg->clients[i]->socket_fd) < 0) {
+    ClientList *clients = registry_acquire(reg); // no lock held while sending
+    for (size_t i = 0; i < clients->count; ++i) {
+        Message msg = { .type = MSG_GAME_OVER };
+        const Player *p = game_find_player(game, clients->clients[i]->handle);
+        if (p) {
+            const ActArgGameOver r = player_result(game, p);
+            if (game_over_to_msg(r.score, r.time_elapsed, &msg) < 0) msg = (Message){ .type = MSG_GAME_OVER };
+        }
+        if (client_send(clients->clients[i], msg) < 0) {
             log_server("FAILED: to send game over to client\n");
             rc = -1;
-            break;
         }
     }
-    pthread_mutex_unlock(&reg->lock);
+    registry_release(clients);
 
     return rc;
 }
@@ -179,32 +383,79 @@ int broadcast_game_over(ClientRegistry *reg) {
 int broadcast_error(ClientRegistry *reg, const char *error_msg) {
 
     int rc = 0;
-    pthread_mutex_lock(&reg->lock);
-    for (size_t i = 0; i < reg->count; ++i) {
-        if (send_error(reg->clients[i]->socket_fd, error_msg) < 0) {
+    ClientList *clients = registry_acquire(reg);
+    for (size_t i = 0; i < clients->count; ++i) {
+        Message msg;
+        if (error_to_msg(error_msg, &msg) < 0 || client_send(clients->clients[i], msg) < 0) {
             log_server("FAILED: to send error message to client\n");
             rc = -1;
-            break;
         }
     }
-    pthread_mutex_unlock(&reg->lock);
+    registry_release(clients);
 
     return rc;
 }
 
-void game_add_player(GameState *game, const int player_id) {
+/**
+ * Looks a player up by handle in O(1).
+ *
+ * @param game  Pointer to the game state.
+ * @param h     Player handle carried by the event.
+ * @return Player, or NULL if not in game or the handle is stale.
+ */
+Player *game_find_player(const GameState *game, const PlayerHandle h) {
+    if (h.slot >= MAX_PLAYERS) return NULL;
+    const int idx = game->player_index[h.slot];
+    if (idx < 0 || !handle_eq(game->players.slots[idx].handle, h)) return NULL;
+    return &game->players.slots[idx];
+}
 
-    Player *new_players = realloc(game->players, (game->player_count + 1) * sizeof(Player));
-    if (new_players == NULL) {
-        // allocation failed, keep old `game->players` intact
-        // optionally log or handle error here
-        return;
+/**
+ * Adds a player with a new snake on a spawn place picked by the spawn planner.
+ *
+ * The place is a horizontal run of empty cells facing right with
+ * SPAWN_CLEARANCE empty cells ahead of the head, taken from the planner's
+ * set of clear places, preferring one at least head_clearance cells away
+ * from every live head.
+ *
+ * @param game  Pointer to the game state.
+ * @param h     Handle of the connected player.
+ * @return true if the player is in game, false if the map has no room or memory ran out.
+ */
+bool game_add_player(GameState *game, const PlayerHandle h) {
+    if (h.slot >= MAX_PLAYERS) return false; // invalid
+    if (game_find_player(game, h)) return true; // already in game
+
+    // keep away from where the others are heading
+    Position heads[MAX_PLAYERS];
+    size_t head_count = 0;
+    for (size_t i = 0; i < game->players.count; ++i) {
+        const Player *other = player_pool_at(&game->players, i);
+        if (other->snake.length > 0) heads[head_count++] = *snake_at(&other->snake, 0);
+    }
+
+    Position head;
+    if (!spawn_pick(&game->grid.spawns, heads, head_count, game->head_clearance, &head)) {
+        log_server("no room to spawn a snake, map full\n");
+        return false;
     }
-    game->players = new_players;
 
-    Player *p = &game->players[game->player_count];
+    // snake first, so a failure leaves no half-added player behind
+    Snake snake;
+    if (snake_init(&snake, INITIAL_SNAKE_LENGTH, &game->bodies) < 0) {
+        log_server("FAILED: to allocate snake body\n");
+        return false;
+    }
+
+    Player *p = player_pool_take(&game->players);
+    if (p == NULL) {
+        // pool has a slot per handle slot, only a removal not yet collected can leave it short
+        snake_destroy(&snake, &game->bodies);
+        log_server("FAILED: no free player slot\n");
+        return false;
+    }
 
-    p->id = player_id;
+    p->handle = h;
     p->score = 0;
 
     p->paused = false;
@@ -214,166 +465,115 @@ void game_add_player(GameState *game, const int player_id) {
     timer_set(&p->timer, 0); // start at 0
 
     // its snake
-    p->snake.body = malloc(INITIAL_SNAKE_LENGTH * sizeof(Position));
-    p->snake.length = INITIAL_SNAKE_LENGTH;
-    p->snake.capacity = INITIAL_SNAKE_LENGTH;
+    p->snake = snake;
     p->snake.direction = DIR_RIGHT;
     p->snake.next_direction = DIR_RIGHT;
 
-    // initialize snake position: horizontally, centered, and away from walls/obstacles
-    bool valid_snake_pos = false;
-    while (!valid_snake_pos) {
-        // choose head x so that the whole snake fits within \[0, width)
-        const int max_head_x = game->width - 1;
-        int min_head_x = INITIAL_SNAKE_LENGTH - 1;
-        if (max_head_x <= min_head_x) {
-            // fallback: clamp to valid range
-            min_head_x = 0;
-        }
-
-        const int head_x = rand() % (max_head_x - min_head_x + 1) + min_head_x;
-        const int head_y = rand() % game->height;
-
-        valid_snake_pos = true;
-
-        // check each segment for obstacle collision
-        for (size_t i = 0; i < INITIAL_SNAKE_LENGTH && valid_snake_pos; ++i) {
-            int seg_x = head_x - (int)i;
-            int seg_y = head_y;
-
-            // defensive bounds check
-            if (seg_x < 0 || seg_x >= game->width || seg_y < 0 || seg_y >= game->height) {
-                valid_snake_pos = false;
-                break;
-            }
-
-            for (size_t j = 0; j < game->obstacle_count; ++j) {
-                if (game->obstacles[j].pos.x == seg_x &&
-                    game->obstacles[j].pos.y == seg_y) {
-                    valid_snake_pos = false;
-                    break;
-                    }
-            }
-        }
-
-        if (valid_snake_pos) {
-            for (size_t i = 0; i < INITIAL_SNAKE_LENGTH; ++i) {
-                p->snake.body[i].x = head_x - (int)i;
-                p->snake.body[i].y = head_y;
-            }
-        }
+    // horizontally, body extending left from the head
+    for (size_t i = 0; i < INITIAL_SNAKE_LENGTH; ++i) {
+        *snake_at(&p->snake, i) = (Position){ head.x - (int)i, head.y };
+        grid_snake_enter(&game->grid, *snake_at(&p->snake, i));
     }
 
-    game->player_count++;
+    game->player_index[h.slot] = (int)player_pool_slot(&game->players, p);
 
     log_server("Player added to game\n");
-
+    return true;
 }
 
-void game_remove_player(GameState *game, const int player_id) {
-
-    // find player index
-    size_t idx = (size_t)-1;
-    for (size_t i = 0; i < game->player_count; ++i) {
-        if (game->players[i].id == player_id) {
-            idx = i;
-            break;
-        }
-    }
-
-    if (idx != (size_t)-1) {
-        free(game->players[idx].snake.body);
-
-        for (size_t i = idx + 1; i < game->player_count; ++i) {
-            game->players[i - 1] = game->players[i];
-        }
-
-        game->player_count--;
-
-        if (game->player_count == 0) {
-            free(game->players);
-            game->players = NULL;
-        } else {
-            Player *tmp = realloc(game->players, game->player_count * sizeof(Player));
-            if (tmp != NULL) {
-                game->players = tmp;
-            }
-        }
+// takes a player off the board and out of lookups, its slot is recycled by the next collect
+static void game_drop_player(GameState *game, Player *p) {
+    for (size_t i = 0; i < p->snake.length; ++i) {
+        grid_snake_leave(&game->grid, *snake_at(&p->snake, i));
     }
+    snake_destroy(&p->snake, &game->bodies);
+    game->player_index[p->handle.slot] = -1;
+    player_pool_retire(&game->players, p);
+}
 
+/**
+ * Removes a player between ticks (disconnect), freeing its slot right away.
+ *
+ * @param game  Pointer to the game state.
+ * @param h     Handle of the leaving player, ignored if not in game.
+ */
+void game_remove_player(GameState *game, const PlayerHandle h) {
+    Player *p = game_find_player(game, h);
+    if (p == NULL) return;
+
+    game_drop_player(game, p);
+    player_pool_collect(&game->players);
 }
 
-void game_update_player_direction(const GameState *game, const int player_id, const Direction dir) {
-    for (size_t i = 0; i < game->player_count; ++i) {
-        if (game->players[i].id == player_id) {
-            // prevent reversing direction
-            const Direction current_dir = game->players[i].snake.direction;
-            if ((current_dir == DIR_UP && dir != DIR_DOWN) ||
-                (current_dir == DIR_DOWN && dir != DIR_UP) ||
-                (current_dir == DIR_LEFT && dir != DIR_RIGHT) ||
-                (current_dir == DIR_RIGHT && dir != DIR_LEFT)) {
-                game->players[i].snake.next_direction = dir;
-            }
-            break;
-        }
+void game_update_player_direction(const GameState *game, const PlayerHandle h, const Direction dir) {
+    Player *p = game_find_player(game, h);
+    if (!p) return;
+
+    // prevent reversing direction
+    const Direction current_dir = p->snake.direction;
+    if ((current_dir == DIR_UP && dir != DIR_DOWN) ||
+        (current_dir == DIR_DOWN && dir != DIR_UP) ||
+        (current_dir == DIR_LEFT && dir != DIR_RIGHT) ||
+        (current_dir == DIR_RIGHT && dir != DIR_LEFT)) {
+        p->snake.next_direction = dir;
     }
 }
 
-void game_pause_player(const GameState *game, const int player_id) {
-    for (size_t i = 0; i < game->player_count; ++i) {
-        if (game->players[i].id == player_id) {
-            game->players[i].paused = true;
-            game->players[i].resume_ev_pending = true;
-            break;
-        }
-    }
+void game_pause_player(const GameState *game, const PlayerHandle h) {
+    Player *p = game_find_player(game, h);
+    if (!p) return;
+    p->paused = true;
+    p->resume_ev_pending = true;
 }
 
-void game_schedule_resume_player(const GameState *game, const int player_id) {
-    for (size_t i = 0; i < game->player_count; ++i) {
-        if (game->players[i].id == player_id) {
-            game->players[i].resume_ev_pending = false;
-            break;
-        }
-    }
+void game_schedule_resume_player(const GameState *game, const PlayerHandle h) {
+    Player *p = game_find_player(game, h);
+    if (p) p->resume_ev_pending = false;
 }
 
-void game_resume_player(const GameState *game, const int player_id) {
-    for (size_t i = 0; i < game->player_count; ++i) {
-        if (game->players[i].id == player_id && !game->players[i].resume_ev_pending) {
-            game->players[i].paused = false;
-            break;
-        }
-    }
+void game_resume_player(const GameState *game, const PlayerHandle h) {
+    Player *p = game_find_player(game, h);
+    if (p && !p->resume_ev_pending) p->paused = false;
 }
 
+/**
+ * Advances every snake by one cell and resolves what it ran into.
+ *
+ * Players that die are dropped from the board at once but keep their pool
+ * slot until the end of the tick, so the iteration order does not shift
+ * under the loop and no Player pointer goes stale while it runs.
+ *
+ * @param game       Pointer to the game state.
+ * @param easy_mode  Snakes wrap around the walls instead of dying.
+ * @param aq         Action queue for game over messages.
+ */
 void game_update(GameState *game, const bool easy_mode, ActionQueue *aq) {
     // update each player's snake position
-    for (size_t i = 0; i < game->player_count; ++i) {
-        Player *p = &game->players[i];
+    for (size_t i = 0; i < game->players.count; ++i) {
+        Player *p = player_pool_at(&game->players, i);
         if (p->paused) continue;
 
-        move_player(p);
+        move_player(p, &game->grid);
 
         // check collisions
-        if (player_player_collision(p, game->players, game->player_count) ||
-            player_obstacle_collision(p, game->obstacles, game->obstacle_count)) {
-            // ACT send game over to p->player_id
-            enqueue_action(aq, (Action){ .type = ACT_SEND_GAME_OVER, .u.player_id = p->id });
+        if (player_player_collision(p, &game->grid) ||
+            player_obstacle_collision(p, &game->grid)) {
+            // ACT send game over to p->handle
+            enqueue_action(aq, (Action){ .type = ACT_SEND_GAME_OVER, .u.over = player_result(game, p) });
             // remove player
-            game_remove_player(game, p->id);
+            game_drop_player(game, p);
             continue; // skip further checks for this player
         }
 
         if (player_wall_collision(p, game->width, game->height)) {
             if (!easy_mode) {
-                // ACT send game over to p->player_id
-                enqueue_action(aq, (Action){ .type = ACT_SEND_GAME_OVER, .u.player_id = p->id });
+                // ACT send game over to p->handle
+                enqueue_action(aq, (Action){ .type = ACT_SEND_GAME_OVER, .u.over = player_result(game, p) });
                 // remove player
-                game_remove_player(game, p->id);
+                game_drop_player(game, p);
             } else {
                 // wrap around (easy mode)
-                Position *head = &p->snake.body[0];
+                Position *head = snake_at(&p->snake, 0);
                 if (head->x < 0) {
                     head->x = game->width - 1;
                 } else if (head->x >= game->width) {
@@ -384,23 +584,28 @@ void game_update(GameState *game, const bool easy_mode, ActionQueue *aq) {
                 } else if (head->y >= game->height) {
                     head->y = 0;
                 }
+                grid_snake_enter(&game->grid, *head); // was off the board until now, not checked until next tick
             }
             continue; // skip further checks for this player
         }
 
-        const int collided_fruit_idx = player_fruit_collision(p, game->fruits, game->fruit_count);
+        const int collided_fruit_idx = player_fruit_collision(p, &game->grid);
         if (collided_fruit_idx >= 0) {
             // eat and deactivate fruit
             Fruit *f = &game->fruits[collided_fruit_idx]; f->active = false; p->score += 1;
+            grid_set_fruit(&game->grid, f->pos, -1);
 
             // grow player
-            grow_player(p);
+            grow_player(p, &game->grid, &game->bodies);
 
             // add new fruit
             game_add_fruit(game);
         }
     }
 
+    // free the slots of players who died this tick
+    player_pool_collect(&game->players);
+
     // remove inactive fruits
     for (size_t i = game->fruit_count; i-- > 0; ) {
         if (!game->fruits[i].active) {
@@ -409,50 +614,29 @@ void game_update(GameState *game, const bool easy_mode, ActionQueue *aq) {
     }
 }
 
-void game_add_fruit(GameState *game) {
-    Fruit *new_fruits = realloc(game->fruits, (game->fruit_count + 1) * sizeof(Fruit));
-    if (new_fruits == NULL) {
-        // allocation failed, do not modify existing fruits
-        return;
-    }
-
-    game->fruits = new_fruits;
-
-    Fruit f = {0};
-
-    // find valid position
-    bool valid_pos = false;
-    while (!valid_pos) {
-        f.pos.x = 1 + rand() % (game->width  - 2);
-        f.pos.y = 1 + rand() % (game->height - 2);
-        f.active = true;
-
-        valid_pos = true;
-
-        // check collision with players
-        for (size_t i = 0; i < game->player_count; ++i) {
-            const Player *p = &game->players[i];
-
-            if (player_fruit_collision(p, &f, 1) >= 0) {
-                valid_pos = false;
-                break;
-            }
-        }
-        if (!valid_pos) continue;
-
-        // check collision with obstacles
-        for (size_t i = 0; i < game->obstacle_count; ++i) {
-            if (game->obstacles[i].pos.x == f.pos.x &&
-                game->obstacles[i].pos.y == f.pos.y) {
-                valid_pos = false;
-                break;
-                }
-        }
+/**
+ * Spawns a fruit on a uniformly random free cell.
+ *
+ * Free cells (no snake, fruit or obstacle, not on the border) are kept in
+ * the grid's free-cell set, so this takes O(1) however full the board is.
+ *
+ * @param game  Pointer to the game state.
+ * @return true if a fruit was added, false if no cell is free or the fruit array is full.
+ */
+bool game_add_fruit(GameState *game) {
+    if (game->fruit_count == FRUIT_CAPACITY) return false; // not with joins capped at MAX_FRUITS
+
+    Fruit f = { .active = true };
+    if (!grid_random_free(&game->grid, &f.pos)) {
+        log_server("board full, no fruit spawned\n");
+        return false;
     }
 
+    grid_set_fruit(&game->grid, f.pos, (int)game->fruit_count);
     game->fruits[game->fruit_count++] = f;
 
     log_server("Fruit added to game\n");
+    return true;
 }
 
 static void game_remove_fruit(GameState *game, const size_t index) {
@@ -460,6 +644,7 @@ static void game_remove_fruit(GameState *game, const size_t index) {
 
     for (size_t i = index + 1; i < game->fruit_count; ++i) {
         game->fruits[i - 1] = game->fruits[i];
+        if (game->fruits[i - 1].active) grid_set_fruit(&game->grid, game->fruits[i - 1].pos, (int)(i - 1));
     }
     game->fruit_count--;
 }
@@ -472,6 +657,19 @@ void game_spawn_obstacles_from_file(GameState *game, const char *file_path) {
 }
 
 
+/**
+ * Scatters obstacles so that no two of them touch, without comparing them pairwise.
+ *
+ * Two cells of one 2x2 block always touch, so the board is seen as a grid
+ * of blocks holding at most one obstacle each. Random blocks are drawn and
+ * get their obstacle on the first of their cells (tried from a random one)
+ * with no obstacle around, which is a constant time check in the grid's
+ * obstacle bitmap. The whole generator is linear in the number of
+ * obstacles, which is at most a small fraction of the blocks, so draws
+ * rarely miss; one that keeps missing stops the generator early as before.
+ *
+ * @param game  Pointer to the game state, its grid must be initialized.
+ */
 void game_spawn_obstacles_random(GameState *game) {
 
     // choose num of obstacles at random based on board size
@@ -480,29 +678,33 @@ void game_spawn_obstacles_random(GameState *game) {
 
     game->obstacles = malloc(max_obstacles * sizeof(Obstacle));
     game->obstacle_count = 0;
+    if (!game->obstacles) {
+        log_server("FAILED: to allocate obstacles\n");
+        return;
+    }
+
+    const int blocks_x = (game->width + 1) / 2;
+    const int blocks_y = (game->height + 1) / 2;
+    const size_t blocks = (size_t)blocks_x * (size_t)blocks_y;
+    const int max_draws = 64; // per obstacle, misses are rare below 1 obstacle in 30 blocks
 
-    // easy algorithm: try to place obstacles randomly, not allowing any neighbours
     for (size_t i = 0; i < max_obstacles; ++i) {
-        const int max_tries = 1000;
         bool placed = false;
 
-        for (int t = 0; t < max_tries && !placed; ++t) {
-            Obstacle o;
-            o.pos.x = rand() % game->width;
-            o.pos.y = rand() % game->height;
-
-            // check 8 neighbors \+ self for any existing obstacle
-            bool has_neighbor = false;
-            for (size_t j = 0; j < game->obstacle_count && !has_neighbor; ++j) {
-                const int dx = abs(game->obstacles[j].pos.x - o.pos.x);
-                const int dy = abs(game->obstacles[j].pos.y - o.pos.y);
-                if (dx <= 1 && dy <= 1) {
-                    has_neighbor = true;
-                }
-            }
+        for (int d = 0; d < max_draws && !placed; ++d) {
+            const size_t b = (size_t)rand() % blocks;
+            const int bx = (int)(b % (size_t)blocks_x);
+            const int by = (int)(b / (size_t)blocks_x);
+
+            const int first = rand() % 4;
+            for (int k = 0; k < 4 && !placed; ++k) {
+                const int cell = (first + k) % 4;
+                const Position pos = { 2 * bx + cell % 2, 2 * by + cell / 2 };
+                if (pos.x >= game->width || pos.y >= game->height) continue;
+                if (grid_obstacle_near(&game->grid, pos)) continue; // also true for a block already taken
 
-            if (!has_neighbor) {
-                game->obstacles[game->obstacle_count++] = o;
+                grid_set_obstacle(&game->grid, pos);
+                game->obstacles[game->obstacle_count++] = (Obstacle){ pos };
                 placed = true;
             }
         }
@@ -5,12 +5,18 @@
 #include "events.h"
 #include "registry.h"
 #include "physics.h"
+#include "players.h"
+#include "bodies.h"
+#include "timers.h"
+#include "tuning.h"
+#include "encoder.h"
 
 typedef struct {
-    Player *players;
-    size_t player_count;
+    PlayerPool players; // fixed slots, iterated in join order
+    BodyPool bodies; // snake bodies by ring capacity
+    int player_index[MAX_PLAYERS]; // handle slot -> pool slot, -1 if none
 
-    Fruit *fruits;
+    Fruit *fruits; // FRUIT_CAPACITY allocated once, eaten ones stay until the end of the tick
     size_t fruit_count;
 
     Obstacle *obstacles;
@@ -18,38 +24,66 @@ typedef struct {
 
     int width;
     int height;
+    Grid grid; // occupancy of every cell, snakes, fruits and obstacles
 
     Timer timer;
     bool wait_for_end_pending;
 
+    TimerWheel timers; // delayed events (resume wait, end wait), tick thread only
+    int tick_rate; // ticks per second, fixed for the game and told to every client
+    int head_clearance; // cells a joining snake keeps from live heads when the map allows
+    TickClock clock; // tick pacing, its cached now is the time of the whole tick
+    SnapshotRate snapshots; // how often ticks broadcast snapshots
+    TickJitter jitter; // tick lateness, logged at shutdown
+
+    bool idle; // nothing could change at the end of the last tick (no one moving)
+    struct timespec heartbeat_at; // next snapshot while idle
+    uint64_t idle_waits; // times the loop slept instead of ticking
+    int64_t idle_ns; // time spent asleep in total
+
 } GameState;
 
+// room for every fruit on the board plus one eaten per player in a single tick
+#define FRUIT_CAPACITY (MAX_FRUITS + MAX_PLAYERS)
+
+// game settings given as `--` options, the same for every player
+typedef struct {
+    int tick_rate; // game updates per second, sent to clients with MSG_READY
+    bool adaptive_snapshots; // shed snapshot rate when ticks get close to their budget
+    int head_clearance; // cells a joining snake keeps from the heads of live snakes
+} GameOptions;
+
+void game_options_init(GameOptions *o);
+int game_parse_option(GameOptions *o, const char *arg);
+void game_usage(const char *prog);
+
 void game_run(GameState *game, bool timed_mode, bool single_player, bool easy_mode,
-    EventQueue *eq, ActionQueue *aq, ClientRegistry *reg);
+    EventQueue *eq, ActionQueue *aq, ClientRegistry *reg, SnapshotEncoder *enc);
 
-void game_init(GameState *game, int width, int height, int game_time, bool obstacles_enabled,
-    bool random_world, const char *file_path);
-void game_destroy(const GameState *game);
+int game_init(GameState *game, int width, int height, int game_time, bool obstacles_enabled,
+    bool random_world, const char *file_path, const GameOptions *opts);
+void game_destroy(GameState *game);
 void game_update(GameState *game, bool easy_mode, ActionQueue *aq);
 
-void game_broadcast_snapshot(const GameState *game, ActionQueue *aq);
+void game_publish_frame(const GameState *game, SnapshotEncoder *enc);
+bool game_quiescent(const GameState *game);
 
-void game_add_player(GameState *game, int player_id);
-void game_grow_player(GameState *game, int player_id);
-void game_remove_player(GameState *game, int player_id);
-void game_update_player_direction(const GameState *game, int player_id, Direction dir);
+Player *game_find_player(const GameState *game, PlayerHandle h);
+bool game_add_player(GameState *game, PlayerHandle h);
+void game_remove_player(GameState *game, PlayerHandle h);
+void game_update_player_direction(const GameState *game, PlayerHandle h, Direction dir);
 
-void game_pause_player(const GameState *game, int player_id);
-void game_schedule_resume_player(const GameState *game, int player_id);
-void game_resume_player(const GameState *game, int player_id);
+void game_pause_player(const GameState *game, PlayerHandle h);
+void game_schedule_resume_player(const GameState *game, PlayerHandle h);
+void game_resume_player(const GameState *game, PlayerHandle h);
 
-void game_add_fruit(GameState *game);
+bool game_add_fruit(GameState *game);
 static void game_remove_fruit(GameState *game, size_t index);
 void game_spawn_obstacles_random(GameState *game);
 void game_spawn_obstacles_from_file(GameState *game, const char *file_path);
 
 // broadcasting
-int broadcast_game_over(ClientRegistry *reg);
+int broadcast_game_over(ClientRegistry *reg, const GameState *game);
 int broadcast_error(ClientRegistry *reg, const char *error_msg);
 
 #endif //SERPENT_GAME_H
\ No newline at end of file
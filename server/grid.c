@@ -0,0 +1,137 @@
+#include "grid.h"
+#include <stdlib.h>
+#include "config.h"
+#include "logging.h"
+
+int grid_init(Grid *g, const int width, const int height) {
+    const size_t n = (size_t)width * (size_t)height;
+    g->width = width;
+    g->height = height;
+    g->spawns = (SpawnPlanner){0};
+    g->free = (CellSet){0};
+    // zeroed cells are empty, the free set starts as every inner cell
+    g->cells = calloc(n, sizeof(GridCell));
+    g->obstacles = calloc((n + 63) / 64, sizeof(uint64_t));
+    if (!g->cells || !g->obstacles || cell_set_init(&g->free, width, height, 1, width - 2, 1, height - 2) < 0) {
+        log_server("FAILED: to allocate occupancy grid\n");
+        grid_destroy(g);
+        return -1;
+    }
+    if (spawn_init(&g->spawns, width, height, INITIAL_SNAKE_LENGTH, SPAWN_CLEARANCE) < 0) {
+        grid_destroy(g);
+        return -1;
+    }
+    return 0;
+}
+
+void grid_destroy(Grid *g) {
+    free(g->cells);
+    free(g->obstacles);
+    g->cells = NULL;
+    g->obstacles = NULL;
+    cell_set_destroy(&g->free);
+    spawn_destroy(&g->spawns);
+}
+
+static size_t cell_index(const Grid *g, const GridCell *c) {
+    return (size_t)(c - g->cells);
+}
+
+static bool obstacle_bit(const Grid *g, const size_t i) {
+    return (g->obstacles[i / 64] >> (i % 64)) & 1u;
+}
+
+static bool cell_empty(const Grid *g, const GridCell *c) {
+    return c->snakes == 0 && c->fruit_ref == 0 && !obstacle_bit(g, cell_index(g, c));
+}
+
+// keeps the free set and the spawn planner in step when a cell fills up or empties
+static void cell_changed(Grid *g, const GridCell *c, const Position p, const bool was_empty) {
+    const bool empty = cell_empty(g, c);
+    if (empty == was_empty) return;
+
+    const size_t i = cell_index(g, c);
+    if (empty) cell_set_add(&g->free, i); // border cells never take fruit, the set ignores them
+    else cell_set_remove(&g->free, i);
+    spawn_cell_changed(&g->spawns, p, !empty);
+}
+
+bool grid_contains(const Grid *g, const Position p) {
+    return p.x >= 0 && p.x < g->width && p.y >= 0 && p.y < g->height;
+}
+
+// cell at p, NULL outside the board (nothing is ever there)
+const GridCell *grid_cell(const Grid *g, const Position p) {
+    if (!grid_contains(g, p)) return NULL;
+    return &g->cells[(size_t)p.y * (size_t)g->width + (size_t)p.x];
+}
+
+static GridCell *cell_at(Grid *g, const Position p) {
+    return (GridCell *)grid_cell(g, p);
+}
+
+// a snake segment moved onto p
+void grid_snake_enter(Grid *g, const Position p) {
+    GridCell *c = cell_at(g, p);
+    if (!c) return;
+    const bool was_empty = cell_empty(g, c);
+    c->snakes++;
+    cell_changed(g, c, p, was_empty);
+}
+
+// a snake segment left p (tail retracted or snake removed)
+void grid_snake_leave(Grid *g, const Position p) {
+    GridCell *c = cell_at(g, p);
+    if (!c || c->snakes == 0) return;
+    c->snakes--;
+    cell_changed(g, c, p, false);
+}
+
+// records which fruit lies on p, -1 when it was eaten
+void grid_set_fruit(Grid *g, const Position p, const int index) {
+    GridCell *c = cell_at(g, p);
+    if (!c) return;
+    const bool was_empty = cell_empty(g, c);
+    c->fruit_ref = index + 1;
+    cell_changed(g, c, p, was_empty);
+}
+
+void grid_set_obstacle(Grid *g, const Position p) {
+    GridCell *c = cell_at(g, p);
+    if (!c) return;
+    const bool was_empty = cell_empty(g, c);
+    const size_t i = cell_index(g, c);
+    g->obstacles[i / 64] |= (uint64_t)1 << (i % 64);
+    cell_changed(g, c, p, was_empty);
+}
+
+bool grid_obstacle_at(const Grid *g, const Position p) {
+    if (!grid_contains(g, p)) return false;
+    return obstacle_bit(g, (size_t)p.y * (size_t)g->width + (size_t)p.x);
+}
+
+// obstacle on p or any of its 8 neighbours
+bool grid_obstacle_near(const Grid *g, const Position p) {
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            if (grid_obstacle_at(g, (Position){ p.x + dx, p.y + dy })) return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Picks a uniformly random free inner cell in O(1).
+ *
+ * @param g    Pointer to the grid.
+ * @param out  Receives the position of the picked cell.
+ * @return true on success, false if no cell is free.
+ */
+bool grid_random_free(const Grid *g, Position *out) {
+    size_t i;
+    if (!cell_set_pick(&g->free, &i)) return false;
+
+    out->x = (int)(i % (size_t)g->width);
+    out->y = (int)(i / (size_t)g->width);
+    return true;
+}
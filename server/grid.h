@@ -0,0 +1,48 @@
+#ifndef SERPENT_GRID_H
+#define SERPENT_GRID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+#include "cellset.h"
+#include "spawn.h"
+
+typedef struct {
+    int32_t fruit_ref; // index into GameState.fruits of the active fruit here + 1, 0 none (so cells start zeroed)
+    uint16_t snakes; // snake segments on the cell (a freshly grown tail counts twice)
+} GridCell;
+
+// width x height occupancy grid owned by the tick thread, kept in step with
+// every snake move, fruit and obstacle so collision checks are one lookup
+// positions outside the board are never stored (easy mode heads leave it for a moment)
+// the free-cell set holds every inner cell (not on the border) with nothing on it,
+// for O(1) updates and uniform picks
+// every array starts zeroed, so setting a grid up costs no per-cell work and memory
+// is only touched where something happens on the board
+typedef struct {
+    int width;
+    int height;
+    GridCell *cells; // row major, y * width + x
+    uint64_t *obstacles; // packed bitmap, bit y * width + x set when the cell holds an obstacle
+
+    CellSet free; // empty inner cells
+
+    SpawnPlanner spawns; // where a joining snake fits, fed by the same cell changes
+} Grid;
+
+int grid_init(Grid *g, int width, int height);
+void grid_destroy(Grid *g);
+
+bool grid_contains(const Grid *g, Position p);
+const GridCell *grid_cell(const Grid *g, Position p);
+
+void grid_snake_enter(Grid *g, Position p);
+void grid_snake_leave(Grid *g, Position p);
+void grid_set_fruit(Grid *g, Position p, int index);
+void grid_set_obstacle(Grid *g, Position p);
+bool grid_obstacle_at(const Grid *g, Position p);
+bool grid_obstacle_near(const Grid *g, Position p);
+
+bool grid_random_free(const Grid *g, Position *out);
+
+#endif //SERPENT_GRID_H
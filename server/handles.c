@@ -0,0 +1,33 @@
+#include "handles.h"
+
+void handle_table_init(HandleTable *t) {
+    t->free_count = MAX_PLAYERS;
+    for (uint32_t i = 0; i < MAX_PLAYERS; ++i) {
+        t->gens[i] = 1; // zeroed handle is never valid
+        t->free_slots[i] = MAX_PLAYERS - 1 - i; // lowest slots handed out first
+    }
+}
+
+/**
+ * Takes a free slot and returns a handle for its current generation.
+ *
+ * @param t  Pointer to the handle table.
+ * @param h  Output handle.
+ * @return false if all MAX_PLAYERS slots are in use.
+ */
+bool handle_alloc(HandleTable *t, PlayerHandle *h) {
+    if (t->free_count == 0) return false;
+
+    const uint32_t slot = t->free_slots[--t->free_count];
+    h->slot = slot;
+    h->gen = t->gens[slot];
+    return true;
+}
+
+// returns slot to the table, bumping its generation invalidates every copy of the handle
+void handle_release(HandleTable *t, const PlayerHandle h) {
+    if (h.slot >= MAX_PLAYERS || t->gens[h.slot] != h.gen) return; // stale or already released
+
+    if (++t->gens[h.slot] == 0) t->gens[h.slot] = 1; // skip 0 on wrap
+    t->free_slots[t->free_count++] = h.slot;
+}
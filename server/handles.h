@@ -0,0 +1,33 @@
+#ifndef SERPENT_HANDLES_H
+#define SERPENT_HANDLES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+
+// identifies a player across threads (registry, events, actions, game state)
+// slot indexes fixed size per-player tables, generation changes whenever the
+// slot is reused so a handle of a departed player never matches its successor
+typedef struct {
+    uint32_t slot;
+    uint32_t gen;
+} PlayerHandle;
+
+// allocator of player handles, assigned at accept
+// not synchronized on its own, the registry serializes access with its writer lock
+typedef struct {
+    uint32_t gens[MAX_PLAYERS]; // current generation of each slot (never 0)
+    uint32_t free_slots[MAX_PLAYERS]; // stack of unused slots
+    size_t free_count;
+} HandleTable;
+
+void handle_table_init(HandleTable *t);
+bool handle_alloc(HandleTable *t, PlayerHandle *h);
+void handle_release(HandleTable *t, PlayerHandle h);
+
+static inline bool handle_eq(const PlayerHandle a, const PlayerHandle b) {
+    return a.slot == b.slot && a.gen == b.gen;
+}
+
+#endif //SERPENT_HANDLES_H
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/un.h>
@@ -21,14 +22,36 @@ int main(int argc, char **argv) {
     // game configuration comes as command line arguments
     // --------------------------------------------------------
     // todo maybe game/world size ... but how to sync with client ?
-    const char *socket_path = argc > 1 ? argv[1] : NULL;
-    const bool single_player = argc > 2 ? argv[2][0] == '1' : true;
+    // `--` options (game settings, scheduling) may appear anywhere, the rest are positional
+    GameOptions game_opts;
+    game_options_init(&game_opts);
+    SchedOptions sched;
+    sched_options_init(&sched);
+    const char *args[7] = {0};
+    int nargs = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--", 2) == 0) {
+            int rc = game_parse_option(&game_opts, argv[i]);
+            if (rc == 0) rc = sched_parse_option(&sched, argv[i]);
+            if (rc <= 0) {
+                fprintf(stderr, "%s option: %s\n", rc < 0 ? "invalid value for" : "unknown", argv[i]);
+                game_usage(argv[0]);
+                sched_usage(argv[0]);
+                exit(1);
+            }
+        } else if (nargs < (int)LEN(args)) {
+            args[nargs++] = argv[i];
+        }
+    }
+
+    const char *socket_path = nargs > 0 ? args[0] : NULL;
+    const bool single_player = nargs > 1 ? args[1][0] == '1' : true;
     char *endptr = NULL;
-    const long tmp_game_time = argc > 3 ? strtol(argv[3], &endptr, 10) : -1;
+    const long tmp_game_time = nargs > 2 ? strtol(args[2], &endptr, 10) : -1;
     const int game_time = (endptr && *endptr == '\0') ? (int)tmp_game_time : -1; // default no limit (standard mode) ... game over after 10 sec when last player left
-    const bool obstacles_enabled = argc > 4 ? argv[4][0] == '1' : false; // default easy world
-    const bool random_world = argc > 5 ? argv[5][0] == '1' : true; // if hard world default is random obstacles
-    const char *obstacles_file_path = argc > 6 ? argv[6] : NULL;
+    const bool obstacles_enabled = nargs > 3 ? args[3][0] == '1' : false; // default easy world
+    const bool random_world = nargs > 4 ? args[4][0] == '1' : true; // if hard world default is random obstacles
+    const char *obstacles_file_path = nargs > 5 ? args[5] : NULL;
 
     log_server(" ------------ Server started ----------- \n");
     log_server(" ------------ Args ----------- \n");
@@ -45,14 +68,32 @@ int main(int argc, char **argv) {
     log_server(buf);
     snprintf(buf, sizeof buf, "obstacles file path %s\n", obstacles_file_path ? obstacles_file_path : "NULL");
     log_server(buf);
+    snprintf(buf, sizeof buf, "cpus tick %s worker %s io %s\n", sched.tick_cpus ? sched.tick_cpus : "any",
+             sched.worker_cpus ? sched.worker_cpus : "any", sched.io_cpus ? sched.io_cpus : "any");
+    log_server(buf);
+    snprintf(buf, sizeof buf, "realtime %d priority %d\n", sched.realtime ? 1 : 0, sched.rt_priority);
+    log_server(buf);
+    snprintf(buf, sizeof buf, "tick rate %d adaptive snapshots %d head clearance %d\n", game_opts.tick_rate,
+             game_opts.adaptive_snapshots ? 1 : 0, game_opts.head_clearance);
+    log_server(buf);
     log_server(" ------------ ---- ----------- \n");
 
     if (socket_path == NULL) {
         fprintf(stderr, "socket_path is NULL\n");
-        fprintf(stderr, "Usage: %s <socket_path> [single_player(1|0)] [game_time_seconds] [obstacles_enabled(1|0)] [random_world(1|0)] [obstacles_file_path]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <socket_path> [single_player(1|0)] [game_time_seconds] [obstacles_enabled(1|0)] [random_world(1|0)] [obstacles_file_path] [--options]\n", argv[0]);
+        game_usage(argv[0]);
+        sched_usage(argv[0]);
         exit(1);
     }
 
+    // world is built before the socket exists, so a server that cannot build it never takes a client
+    // --------------------------------------------------------
+    GameState state;
+    if (game_init(&state, WORLD_WIDTH, WORLD_HEIGHT, game_time, obstacles_enabled, random_world, obstacles_file_path,
+                  &game_opts) < 0) {
+        log_server("FAILED: to build the game world\n");
+        exit(1); // client fails on timeout waiting for the socket
+    }
 
     // handle connections + input receiving
     // --------------------------------------------------------
@@ -66,7 +107,6 @@ int main(int argc, char **argv) {
     ClientRegistry registry;
     registry_init(&registry);
 
-    _Atomic bool accepting = true;
     _Atomic bool running = true;
     _Atomic bool error = false;
 
@@ -76,30 +116,43 @@ int main(int argc, char **argv) {
     ActionQueue actions;
     action_queue_init(&actions);
 
-    pthread_t accept_thread;
-    RecvInputThreadArgs recv_args = {&events, -1, &running}; // client_fd will be set in accept_connection
-    AcceptLoopThreadArgs args = {&registry, listen_fd, &accepting, &recv_args};
+    Reactor reactor;
+    if (reactor_init(&reactor, &events, &registry) < 0) {
+        close(listen_fd);
+        unlink(socket_path);
+        exit(1); // client fails on timeout
+    }
 
     // accept very first connection in main thread to avoid race
-    if (accept_connection(&registry, listen_fd, &recv_args) == -1) error=true; // blocking call; accept one and return
+    if (accept_connection(&registry, listen_fd, &reactor) == -1) error=true; // blocking call; accept one and return
     if (single_player) {
         log_server("not accepting any more messages \n");
         close(listen_fd);
         unlink(socket_path);
     } else {
         log_server("MULTIPLAYER\n");
-        // in multiplayer spawn accept thread
-
-        const int rc = pthread_create(&accept_thread, NULL, accept_loop_thread, &args);
-        if (rc != 0) {
-            // handle error
-            log_server("FAILED: to start accepting THREAD \n");
+        // in multiplayer reactor also accepts new connections
+        if (reactor_add_listener(&reactor, listen_fd) < 0) {
             close(listen_fd);
             unlink(socket_path);
             exit(1); // client fails on timeout
         }
     }
 
+    // I/O reactor thread (all client sockets + listening socket)
+    // --------------------------------------------------------
+    pthread_t io_thread;
+    ReactorThreadArgs reactor_args = {&reactor, &running};
+    if (pthread_create(&io_thread, NULL, reactor_thread, &reactor_args) != 0) {
+        log_server("FAILED: to start reactor THREAD \n");
+        if (!single_player) {
+            close(listen_fd);
+            unlink(socket_path);
+        }
+        exit(1); // client fails on timeout
+    }
+    pin_thread(io_thread, sched.io_cpus, "reactor");
+
     // worker thread
     // --------------------------------------------------------
     pthread_t worker_thread;
@@ -114,22 +167,44 @@ int main(int argc, char **argv) {
         unlink(socket_path);
         exit(1); // client fails on timeout on awaiting server MSG_READY signal
     }
+    pin_thread(worker_thread, sched.worker_cpus, "worker");
+
+    // snapshot encoder thread (serializes published ticks for the worker)
+    // --------------------------------------------------------
+    static SnapshotEncoder encoder; // three world frames, kept off the stack
+    pthread_t encoder_tid;
+    if (encoder_init(&encoder, &actions) < 0 ||
+        pthread_create(&encoder_tid, NULL, encoder_thread, &encoder) != 0) {
+        log_server("FAILED: to start encoder THREAD \n");
+        exit(1); // client fails on timeout on awaiting server MSG_READY signal
+    }
+    pin_thread(encoder_tid, sched.worker_cpus, "encoder");
 
     // game loop
     // --------------------------------------------------------
 
-    GameState state;
-    game_init(&state, WORLD_WIDTH, WORLD_HEIGHT, game_time, obstacles_enabled, random_world, obstacles_file_path);
+    // main thread is the tick thread, other threads already exist so they keep normal policy
+    pin_thread(pthread_self(), sched.tick_cpus, "tick");
+    if (sched.realtime) enable_realtime(sched.rt_priority);
 
-    game_run(&state, game_time >= 0, single_player, !obstacles_enabled, &events, &actions, &registry);
+    game_run(&state, game_time >= 0, single_player, !obstacles_enabled, &events, &actions, &registry, &encoder);
 
     // shutdown
     // --------------------------------------------------------
     log_server("game loop ended\n");
 
-    accepting = false;
+    // encoder goes first, it is the last producer of actions for the worker
+    encoder_close(&encoder);
+    pthread_join(encoder_tid, NULL);
+    encoder_log_stats(&encoder);
+    encoder_destroy(&encoder);
+
     running = false;
+    action_queue_close(&actions); // wake worker so it sees running == false
+    reactor_stop(&reactor); // wake reactor so it sees running == false
 
+    tick_jitter_log(&state.jitter, &state.clock);
+    snapshot_rate_log(&state.snapshots, state.tick_rate, timer_elapsed(&state.timer));
     game_destroy(&state);
 
     log_server("game destroyed\n");
@@ -137,15 +212,21 @@ int main(int argc, char **argv) {
     pthread_join(worker_thread, NULL);
     log_server("worker thread joined\n");
 
-    registry_destroy(&registry); // joins all client threads
-    log_server("registry destroyed (client recv input thread should be joined)\n");
+    pthread_join(io_thread, NULL);
+    log_server("reactor thread joined\n");
+
+    registry_destroy(&registry); // closes all client sockets
+    reactor_destroy(&reactor);
+    log_server("registry and reactor destroyed\n");
+
+    batch_stats_log(&events.stats, "event");
+    action_queue_log_stats(&actions);
 
     event_queue_destroy(&events);
     action_queue_destroy(&actions);
     log_server("event queues destroyed\n");
 
     if (!single_player) {
-        pthread_join(accept_thread, NULL);
         close(listen_fd);
         unlink(socket_path);
     }
@@ -0,0 +1,154 @@
+#include "outbound.h"
+#include <stdlib.h>
+#include <errno.h>
+
+void outbound_init(OutboundQueue *q) {
+    q->head = 0;
+    q->count = 0;
+    q->sent = 0;
+    q->write_armed = false;
+    q->superseded = 0;
+    pthread_mutex_init(&q->lock, NULL);
+}
+
+void outbound_destroy(OutboundQueue *q) {
+    for (size_t i = 0; i < q->count; ++i) {
+        free(q->msgs[(q->head + i) % MAX_OUTBOUND].payload);
+    }
+    q->count = 0;
+    pthread_mutex_destroy(&q->lock);
+}
+
+// removes entry at logical position pos (0 == head), keeps order of the rest
+static void outbound_remove_at(OutboundQueue *q, const size_t pos) {
+    free(q->msgs[(q->head + pos) % MAX_OUTBOUND].payload);
+    for (size_t i = pos + 1; i < q->count; ++i) {
+        q->msgs[(q->head + i - 1) % MAX_OUTBOUND] = q->msgs[(q->head + i) % MAX_OUTBOUND];
+    }
+    q->count--;
+}
+
+/**
+ * Appends a message to the client's outbound queue.
+ *
+ * A new MSG_STATE drops any older snapshot that has not started sending,
+ * so a slow client only ever gets the latest state. If the queue is full
+ * a snapshot is simply dropped, while a control message fails so the
+ * caller can disconnect the stalled client. Caller must hold q->lock.
+ *
+ * @param q    Pointer to the outbound queue.
+ * @param msg  Message to queue, ownership of payload moves to the queue.
+ * @return 0 on success (including dropped snapshot), -1 if a control
+ *         message did not fit.
+ */
+int outbound_push(OutboundQueue *q, const Message msg) {
+    if (msg.type == MSG_STATE) {
+        // first entry may be partially written already, it cannot be replaced
+        const size_t first = q->sent > 0 ? 1 : 0;
+        for (size_t i = q->count; i-- > first; ) {
+            if (q->msgs[(q->head + i) % MAX_OUTBOUND].header.type == MSG_STATE) {
+                outbound_remove_at(q, i);
+                q->superseded++;
+                break; // at most one unsent snapshot is ever queued
+            }
+        }
+    }
+
+    if (q->count == MAX_OUTBOUND) {
+        free(msg.payload);
+        return msg.type == MSG_STATE ? 0 : -1;
+    }
+
+    OutboundMsg *m = &q->msgs[(q->head + q->count) % MAX_OUTBOUND];
+    m->header.type = (uint32_t)msg.type;
+    m->header.payload_size = msg.payload_size;
+    m->payload = msg.payload;
+    q->count++;
+    return 0;
+}
+
+/**
+ * Describes queued output (headers and payloads) as a list of buffers.
+ *
+ * The part of the head message that was already written is skipped.
+ * Caller must hold q->lock and keep it until the buffers were written.
+ *
+ * @param q    Pointer to the outbound queue.
+ * @param iov  Receives the buffers, at least OUTBOUND_IOV_MAX entries.
+ * @return Number of buffers filled, 0 if the queue is empty.
+ */
+int outbound_gather(const OutboundQueue *q, struct iovec *iov) {
+    int iovcnt = 0;
+    size_t skip = q->sent;
+
+    for (size_t i = 0; i < q->count && iovcnt + 2 <= OUTBOUND_IOV_MAX; ++i) {
+        const OutboundMsg *m = &q->msgs[(q->head + i) % MAX_OUTBOUND];
+
+        if (skip < sizeof(m->header)) {
+            iov[iovcnt].iov_base = (char *)&m->header + skip;
+            iov[iovcnt].iov_len = sizeof(m->header) - skip;
+            iovcnt++;
+            skip = 0;
+        } else {
+            skip -= sizeof(m->header);
+        }
+
+        if (m->header.payload_size > 0) {
+            iov[iovcnt].iov_base = (char *)m->payload + skip;
+            iov[iovcnt].iov_len = m->header.payload_size - skip;
+            iovcnt++;
+        }
+        skip = 0;
+    }
+    return iovcnt;
+}
+
+/**
+ * Drops output the socket has accepted, remembering a partial write.
+ *
+ * @param q        Pointer to the outbound queue, caller holds q->lock.
+ * @param written  Bytes written from the buffers of outbound_gather().
+ */
+void outbound_advance(OutboundQueue *q, size_t written) {
+    while (written > 0 && q->count > 0) {
+        OutboundMsg *m = &q->msgs[q->head];
+        const size_t left = sizeof(m->header) + m->header.payload_size - q->sent;
+        if (written < left) {
+            q->sent += written;
+            break;
+        }
+        written -= left;
+        free(m->payload);
+        m->payload = NULL;
+        q->head = (q->head + 1) % MAX_OUTBOUND;
+        q->count--;
+        q->sent = 0;
+    }
+}
+
+/**
+ * Writes as much queued output as the socket accepts without blocking.
+ *
+ * Queued messages are gathered into a single writev() call (headers and
+ * payloads), partial writes are remembered in q->sent. Caller must hold
+ * q->lock.
+ *
+ * @param q   Pointer to the outbound queue.
+ * @param fd  Non-blocking socket file descriptor.
+ * @return 1 if the queue is empty, 0 if the socket is full, -1 on error.
+ */
+int outbound_flush(OutboundQueue *q, const int fd) {
+    while (q->count > 0) {
+        struct iovec iov[OUTBOUND_IOV_MAX];
+        const int iovcnt = outbound_gather(q, iov);
+
+        const ssize_t n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;
+        }
+        outbound_advance(q, (size_t)n);
+    }
+    return 1;
+}
@@ -0,0 +1,41 @@
+#ifndef SERPENT_OUTBOUND_H
+#define SERPENT_OUTBOUND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include "config.h"
+#include "protocol.h"
+
+#define OUTBOUND_IOV_MAX 32 // iovecs per write (header + payload per message)
+
+// per client bounded queue of encoded messages waiting for a writable socket
+// at most one unsent MSG_STATE is kept (newer snapshot supersedes it),
+// control messages (ready, game over, error) are never dropped
+typedef struct {
+    MsgHeader header; // wire header, sent right before payload
+    void *payload; // owned
+} OutboundMsg;
+
+typedef struct {
+    OutboundMsg msgs[MAX_OUTBOUND]; // ring
+    size_t head;
+    size_t count;
+    size_t sent; // bytes of msgs[head] (header + payload) already written
+    bool write_armed; // socket is watched for writability by the reactor
+    size_t superseded; // snapshots replaced before they were sent
+    pthread_mutex_t lock;
+} OutboundQueue;
+
+void outbound_init(OutboundQueue *q);
+void outbound_destroy(OutboundQueue *q);
+
+int outbound_push(OutboundQueue *q, Message msg);
+int outbound_flush(OutboundQueue *q, int fd);
+
+// split flush for callers that submit the write themselves
+int outbound_gather(const OutboundQueue *q, struct iovec *iov);
+void outbound_advance(OutboundQueue *q, size_t written);
+
+#endif //SERPENT_OUTBOUND_H
@@ -1,84 +1,132 @@
 #include "physics.h"
-#include <stdlib.h>
-
-bool player_player_collision(const Player *player, const Player *players, const size_t num_players) {
-    for (size_t i = 0; i < num_players; ++i) {
-        for (size_t j = 0; j < players[i].snake.length; ++j) {
-            if (player->id == players[i].id && j == 0) {
-                continue; // skip own head
-            }
-            if (player->snake.body[0].x == players[i].snake.body[j].x &&
-                player->snake.body[0].y == players[i].snake.body[j].y) {
-                return true;
-            }
-        }
-    }
-    return false;
+#include <string.h>
+
+// head shares its cell with any other segment, own body included
+bool player_player_collision(const Player *player, const Grid *grid) {
+    const GridCell *c = grid_cell(grid, *snake_at(&player->snake, 0));
+    return c && c->snakes > 1; // the head itself is one of them
 }
 
-bool player_obstacle_collision(const Player *player, const Obstacle *obstacles, const size_t num_obstacles) {
-    for (size_t i = 0; i < num_obstacles; ++i) {
-        if (player->snake.body[0].x == obstacles[i].pos.x &&
-            player->snake.body[0].y == obstacles[i].pos.y) {
-            return true;
-        }
-    }
-    return false;
+bool player_obstacle_collision(const Player *player, const Grid *grid) {
+    return grid_obstacle_at(grid, *snake_at(&player->snake, 0));
 }
 
-int player_fruit_collision(const Player *player, const Fruit *fruits, const size_t num_fruits) {
-    for (size_t i = 0; i < num_fruits; ++i) {
-        if (fruits[i].active &&
-            player->snake.body[0].x == fruits[i].pos.x &&
-            player->snake.body[0].y == fruits[i].pos.y) {
-            return (int)i;
-        }
-    }
-    return -1;
+// index of the active fruit under the head, -1 if none
+int player_fruit_collision(const Player *player, const Grid *grid) {
+    const GridCell *c = grid_cell(grid, *snake_at(&player->snake, 0));
+    return c ? c->fruit_ref - 1 : -1;
 }
 
 bool player_wall_collision(const Player *player, const int width, const int height) {
-    if (player->snake.body[0].x < 0 || player->snake.body[0].x >= width ||
-        player->snake.body[0].y < 0 || player->snake.body[0].y >= height) {
+    const Position *head = snake_at(&player->snake, 0);
+    if (head->x < 0 || head->x >= width ||
+        head->y < 0 || head->y >= height) {
         return true;
     }
     return false;
 }
 
-void move_player(Player *player) {
+/**
+ * Moves the snake one cell in its next direction.
+ *
+ * The grid is updated tail first, so a head entering the cell the tail
+ * just left does not collide. A head that left the board is not stored,
+ * the caller either removes the player or wraps the head and enters it.
+ *
+ * @param player  Player to move.
+ * @param grid    Occupancy grid, updated in place.
+ */
+void move_player(Player *player, Grid *grid) {
+    Snake *s = &player->snake;
+
     // Update direction
-    player->snake.direction = player->snake.next_direction;
+    s->direction = s->next_direction;
 
     // move snake head
-    Position new_head = player->snake.body[0];
-    switch (player->snake.direction) {
+    Position new_head = *snake_at(s, 0);
+    switch (s->direction) {
         case DIR_UP:    new_head.y -= 1; break;
         case DIR_DOWN:  new_head.y += 1; break;
         case DIR_LEFT:  new_head.x -= 1; break;
         case DIR_RIGHT: new_head.x += 1; break;
     }
 
-    // shift body segments to follow the previous segment
-    for (size_t seg = player->snake.length - 1; seg > 0; --seg) {
-        player->snake.body[seg] = player->snake.body[seg - 1];
-    }
+    grid_snake_leave(grid, *snake_at(s, s->length - 1));
+
+    // new head goes one slot before the old one, the tail slot is reused later
+    s->head = (s->head - 1) & (s->capacity - 1);
+    *snake_at(s, 0) = new_head;
+    grid_snake_enter(grid, new_head);
+}
+
+/**
+ * Takes a snake body for the given length from the body pool.
+ *
+ * Capacity is rounded up to a power of two so ring indices wrap with a mask.
+ *
+ * @param s       Snake to initialize, segments are left for the caller to set.
+ * @param length  Initial number of segments (at least 1).
+ * @param bodies  Pool the body is taken from.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int snake_init(Snake *s, const size_t length, BodyPool *bodies) {
+    size_t capacity = 1;
+    while (capacity < length) capacity <<= 1;
+
+    s->body = body_alloc(bodies, capacity);
+    if (!s->body) return -1;
+    s->head = 0;
+    s->length = length;
+    s->capacity = capacity;
+    return 0;
+}
 
-    player->snake.body[0] = new_head;
+// gives the body back to the pool
+void snake_destroy(Snake *s, BodyPool *bodies) {
+    body_free(bodies, s->body, s->capacity);
+    s->body = NULL;
+    s->length = 0;
+    s->capacity = 0;
+}
 
+// copies segments head to tail into dst (room for s->length), at most two runs
+void snake_copy_body(const Snake *s, Position *dst) {
+    const size_t first = s->capacity - s->head < s->length ? s->capacity - s->head : s->length;
+    memcpy(dst, &s->body[s->head], first * sizeof(Position));
+    memcpy(dst + first, s->body, (s->length - first) * sizeof(Position));
 }
 
-void grow_player(Player *player) {
-        const size_t new_length = player->snake.length + 1;
-        Position *new_body = realloc(player->snake.body, new_length * sizeof(Position));
+/**
+ * Adds one segment on the tail, on the cell the tail already occupies.
+ *
+ * When the ring is full it is moved to a body of twice the capacity from
+ * the pool and unrolled so the head starts at slot 0, the old body goes
+ * back to the pool. Otherwise nothing is allocated.
+ *
+ * @param player  Player that ate a fruit.
+ * @param grid    Occupancy grid, updated in place.
+ * @param bodies  Pool snake bodies come from.
+ */
+void grow_player(Player *player, Grid *grid, BodyPool *bodies) {
+    Snake *s = &player->snake;
+
+    if (s->length == s->capacity) {
+        Position *new_body = body_alloc(bodies, 2 * s->capacity);
         if (new_body == NULL) {
             // handle allocation failure (log, disconnect player, etc.)
             return;
         }
+        snake_copy_body(s, new_body);
+        body_free(bodies, s->body, s->capacity);
+        s->body = new_body;
+        s->head = 0;
+        s->capacity *= 2;
+    }
 
-        player->snake.body = new_body;
-
-        // initialize the new tail segment to the previous tail position
-        player->snake.body[new_length - 1] = player->snake.body[new_length - 2];
+    // initialize the new tail segment to the previous tail position
+    const Position tail = *snake_at(s, s->length - 1);
+    *snake_at(s, s->length) = tail;
+    grid_snake_enter(grid, tail);
 
-        player->snake.length = new_length;
+    s->length++;
 }
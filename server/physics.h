@@ -2,17 +2,28 @@
 #define SERPENT_PHYSICS_H
 
 #include "types.h"
+#include "handles.h"
+#include "grid.h"
+#include "bodies.h"
 
+// body is a ring buffer read from `head` towards the tail, a move only writes
+// the new head one slot back and the old tail falls off, whatever the length
 typedef struct {
-    Position *body; // dynamic array of positions
+    Position *body; // ring of `capacity` positions, capacity is a power of two
+    size_t head; // slot of the head segment
     size_t length;
     size_t capacity;
     Direction direction;     // UP, DOWN, LEFT, RIGHT
     Direction next_direction;
 } Snake;
 
+// i-th segment counted from the head (0 is the head)
+static inline Position *snake_at(const Snake *s, const size_t i) {
+    return &s->body[(s->head + i) & (s->capacity - 1)];
+}
+
 typedef struct {
-    int id;
+    PlayerHandle handle;
     Snake snake;
     size_t score;
     bool paused;
@@ -20,12 +31,17 @@ typedef struct {
     Timer timer;
 } Player;
 
-bool player_player_collision(const Player *player, const Player *players, size_t num_players);
-bool player_obstacle_collision(const Player *player, const Obstacle *obstacles, size_t num_obstacles);
-int player_fruit_collision(const Player *player, const Fruit *fruits, size_t num_fruits);
+// collision checks look the head up in the occupancy grid, which must already hold the moved snake
+bool player_player_collision(const Player *player, const Grid *grid);
+bool player_obstacle_collision(const Player *player, const Grid *grid);
+int player_fruit_collision(const Player *player, const Grid *grid);
 bool player_wall_collision(const Player *player, int width, int height);
 
-void move_player(Player *player);
-void grow_player(Player *player);
+int snake_init(Snake *s, size_t length, BodyPool *bodies);
+void snake_destroy(Snake *s, BodyPool *bodies);
+void snake_copy_body(const Snake *s, Position *dst);
+
+void move_player(Player *player, Grid *grid);
+void grow_player(Player *player, Grid *grid, BodyPool *bodies);
 
 #endif //SERPENT_PHYSICS_H
\ No newline at end of file
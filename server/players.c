@@ -0,0 +1,77 @@
+#include "players.h"
+#include <stdlib.h>
+#include "logging.h"
+
+int player_pool_init(PlayerPool *pool) {
+    pool->slots = malloc(MAX_PLAYERS * sizeof(Player));
+    pool->count = 0;
+    pool->retired_count = 0;
+    pool->free_count = 0;
+    if (!pool->slots) {
+        log_server("FAILED: to allocate player pool\n");
+        return -1;
+    }
+
+    // lowest slot on top, so a fresh game fills the pool from the start
+    for (size_t i = MAX_PLAYERS; i-- > 0; ) {
+        pool->free_slots[pool->free_count++] = (uint16_t)i;
+        pool->retired[i] = false;
+    }
+    return 0;
+}
+
+// players' snakes must already be destroyed
+void player_pool_destroy(PlayerPool *pool) {
+    free(pool->slots);
+    pool->slots = NULL;
+    pool->count = 0;
+    pool->free_count = 0;
+    pool->retired_count = 0;
+}
+
+/**
+ * Takes a free slot and appends it to the iteration order.
+ *
+ * @param pool  Pointer to the pool.
+ * @return The player in the slot, left for the caller to fill, or NULL if every slot is taken.
+ */
+Player *player_pool_take(PlayerPool *pool) {
+    if (pool->free_count == 0) return NULL;
+
+    const uint16_t slot = pool->free_slots[--pool->free_count];
+    pool->order[pool->count++] = slot;
+    return &pool->slots[slot];
+}
+
+// marks a player removed, it keeps its slot and place in order until the next collect
+void player_pool_retire(PlayerPool *pool, const Player *p) {
+    const size_t slot = player_pool_slot(pool, p);
+    if (pool->retired[slot]) return;
+    pool->retired[slot] = true;
+    pool->retired_count++;
+}
+
+/**
+ * Drops retired players from the iteration order and frees their slots.
+ *
+ * Remaining players keep their relative order. Called once nothing holds
+ * a Player pointer anymore (end of a tick, or right away outside one).
+ *
+ * @param pool  Pointer to the pool.
+ */
+void player_pool_collect(PlayerPool *pool) {
+    if (pool->retired_count == 0) return;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < pool->count; ++i) {
+        const uint16_t slot = pool->order[i];
+        if (pool->retired[slot]) {
+            pool->retired[slot] = false;
+            pool->free_slots[pool->free_count++] = slot;
+        } else {
+            pool->order[kept++] = slot;
+        }
+    }
+    pool->count = kept;
+    pool->retired_count = 0;
+}
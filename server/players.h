@@ -0,0 +1,40 @@
+#ifndef SERPENT_PLAYERS_H
+#define SERPENT_PLAYERS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "physics.h"
+
+// fixed-capacity player storage: players live in slots that never move, free slots sit on a
+// stack and the live ones are listed densely in join order for iteration; a removed player's
+// slot is only recycled by player_pool_collect, so Player pointers stay valid until then
+typedef struct {
+    Player *slots; // MAX_PLAYERS players, allocated once
+    uint16_t free_slots[MAX_PLAYERS]; // stack of unused slots, first free_count valid
+    size_t free_count;
+    uint16_t order[MAX_PLAYERS]; // slots in play, join order, first count valid
+    size_t count;
+    bool retired[MAX_PLAYERS]; // removed, still in order until collected
+    size_t retired_count;
+} PlayerPool;
+
+int player_pool_init(PlayerPool *pool);
+void player_pool_destroy(PlayerPool *pool);
+
+Player *player_pool_take(PlayerPool *pool);
+void player_pool_retire(PlayerPool *pool, const Player *p);
+void player_pool_collect(PlayerPool *pool);
+
+// i-th player in iteration order (i < count)
+static inline Player *player_pool_at(const PlayerPool *pool, const size_t i) {
+    return &pool->slots[pool->order[i]];
+}
+
+// slot of a player taken from the pool
+static inline size_t player_pool_slot(const PlayerPool *pool, const Player *p) {
+    return (size_t)(p - pool->slots);
+}
+
+#endif //SERPENT_PLAYERS_H
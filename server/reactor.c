@@ -0,0 +1,250 @@
+#include "reactor.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "server.h"
+#include "logging.h"
+
+#define READS_PER_WAKEUP 16 // messages read from one client per wakeup, keeps the loop fair
+
+int reactor_init(Reactor *r, EventQueue *eq, ClientRegistry *reg) {
+    r->eq = eq;
+    r->reg = reg;
+    r->listen_fd = -1;
+    r->connection_count = 0;
+
+    r->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (r->epoll_fd < 0) {
+        log_server("FAILED: to create epoll instance\n");
+        return -1;
+    }
+
+    r->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->wake_fd < 0) {
+        log_server("FAILED: to create reactor wake eventfd\n");
+        close(r->epoll_fd);
+        return -1;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &r->wake_fd };
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->wake_fd, &ev) < 0) {
+        log_server("FAILED: to watch reactor wake eventfd\n");
+        close(r->wake_fd);
+        close(r->epoll_fd);
+        return -1;
+    }
+
+    return 0;
+}
+
+// client sockets are owned (and closed) by the registry
+void reactor_destroy(Reactor *r) {
+    r->connection_count = 0;
+
+    close(r->wake_fd);
+    close(r->epoll_fd);
+}
+
+/**
+ * Hands the listening socket over to the reactor.
+ *
+ * The socket is switched to non-blocking mode so the reactor can accept
+ * every pending connection on a single readiness notification.
+ *
+ * @param r          Pointer to the reactor.
+ * @param listen_fd  Listening socket file descriptor.
+ * @return 0 on success, -1 on error.
+ */
+int reactor_add_listener(Reactor *r, const int listen_fd) {
+    const int flags = fcntl(listen_fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(listen_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        log_server("FAILED: to make listen socket non-blocking\n");
+        return -1;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &r->listen_fd };
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) < 0) {
+        log_server("FAILED: to watch listen socket\n");
+        return -1;
+    }
+
+    r->listen_fd = listen_fd;
+    return 0;
+}
+
+/**
+ * Starts watching a registered client's socket and signals EV_CONNECTED.
+ *
+ * Called from the reactor thread on accept, or from the main thread for
+ * the very first client before the reactor thread is started.
+ *
+ * @param r  Pointer to the reactor.
+ * @param c  Registered client with a non-blocking socket.
+ * @return 0 on success, -1 on error.
+ */
+int reactor_add_client(Reactor *r, Client *c) {
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = c };
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, c->socket_fd, &ev) < 0) {
+        log_server("FAILED: to watch client socket\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&c->out.lock);
+    c->epoll_fd = r->epoll_fd;
+    pthread_mutex_unlock(&c->out.lock);
+    r->connection_count++;
+
+    enqueue_event(r->eq, (Event){ .type = EV_CONNECTED, .u.player = c->handle });
+    return 0;
+}
+
+// interrupts epoll_wait so the reactor thread can observe running == false
+void reactor_stop(Reactor *r) {
+    const uint64_t one = 1;
+    if (write(r->wake_fd, &one, sizeof(one)) < 0) {
+        log_server("FAILED: to wake reactor\n");
+    }
+}
+
+// stops watching the socket, the registry closes it when the player is unregistered
+static void reactor_drop_client(Reactor *r, Client *c) {
+    pthread_mutex_lock(&c->out.lock);
+    c->epoll_fd = -1; // worker must not re-arm writability anymore
+    c->out.write_armed = false;
+    pthread_mutex_unlock(&c->out.lock);
+
+    epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, c->socket_fd, NULL);
+    r->connection_count--;
+}
+
+static void reactor_accept(Reactor *r) {
+    while (true) {
+        if (accept_connection(r->reg, r->listen_fd, r) == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                log_server("error accepting connection\n");
+            }
+            break; // backlog drained
+        }
+    }
+}
+
+/**
+ * Reads and decodes every available message from one client.
+ *
+ * Decoded events are appended to the batch; the batch is flushed to the
+ * event queue whenever it fills up.
+ *
+ * @return true if the connection should be dropped (leave, hangup or error).
+ */
+static bool reactor_read_client(Reactor *r, Client *c, Event *batch, size_t *count) {
+    for (int i = 0; i < READS_PER_WAKEUP; ++i) {
+        Message msg = (Message){0};
+        const int rc = msg_reader_feed(c->socket_fd, &c->reader, &msg);
+        if (rc == 0) return false; // nothing more for now
+        if (rc < 0) {
+            log_server("recv failed or client closed\n");
+            batch[(*count)++] = (Event){ .type = EV_DISCONNECTED, .u.player = c->handle };
+            return true;
+        }
+
+        Event ev = (Event){0};
+        const bool leave = msg.type == MSG_LEAVE;
+        if (msg_to_event(&msg, c->handle, &ev) == 0) {
+            batch[(*count)++] = ev;
+        }
+        message_destroy(&msg);
+
+        if (*count == MAX_REACTOR_EVENTS) {
+            enqueue_events(r->eq, batch, *count);
+            *count = 0;
+        }
+        if (leave) return true; // EV_DISCONNECTED already produced
+    }
+    return false;
+}
+
+/**
+ * Thread entry point of the I/O reactor.
+ *
+ * Waits on epoll for the listening socket and all client sockets, accepts
+ * new connections, decodes client messages into events and pushes every
+ * event produced by one wakeup to the main thread's event queue as a batch.
+ * Sockets of slow clients are also watched for writability so their
+ * pending output is flushed without blocking anyone else.
+ * The thread sleeps in epoll_wait until there is I/O or reactor_stop() is
+ * called.
+ *
+ * @param arg  Pointer to ReactorThreadArgs structure.
+ * @return NULL when the thread terminates.
+ */
+void *reactor_thread(void *arg) {
+    const ReactorThreadArgs *args = arg;
+    Reactor *r = args->reactor;
+    const _Atomic bool *running = args->running;
+
+    struct epoll_event ready[MAX_REACTOR_EVENTS];
+    Event batch[MAX_REACTOR_EVENTS];
+
+    log_server("THREAD: REACTOR started\n");
+
+    while (*running) {
+        const int n = epoll_wait(r->epoll_fd, ready, MAX_REACTOR_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            log_server("FAILED: epoll_wait\n");
+            break;
+        }
+
+        size_t count = 0;
+        for (int i = 0; i < n; ++i) {
+            void *tag = ready[i].data.ptr;
+
+            if (tag == &r->wake_fd) {
+                uint64_t v;
+                while (read(r->wake_fd, &v, sizeof(v)) > 0) {}
+                continue;
+            }
+
+            if (tag == &r->listen_fd) {
+                if (ready[i].events & (EPOLLERR | EPOLLHUP)) {
+                    log_server("epoll: listen socket error/hangup\n");
+                    epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, r->listen_fd, NULL);
+                    r->listen_fd = -1;
+                    continue;
+                }
+                reactor_accept(r);
+                continue;
+            }
+
+            Client *c = tag;
+            bool drop = false;
+            if (ready[i].events & EPOLLOUT) {
+                client_flush(c); // slow client caught up, continue its output
+            }
+            if (ready[i].events & EPOLLIN) {
+                drop = reactor_read_client(r, c, batch, &count);
+            }
+            if (!drop && (ready[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))) {
+                log_server("epoll: client socket error/hangup\n");
+                batch[count++] = (Event){ .type = EV_DISCONNECTED, .u.player = c->handle };
+                drop = true;
+            }
+            if (drop) reactor_drop_client(r, c);
+
+            if (count == MAX_REACTOR_EVENTS) {
+                enqueue_events(r->eq, batch, count);
+                count = 0;
+            }
+        }
+
+        enqueue_events(r->eq, batch, count);
+    }
+
+    log_server("THREAD: REACTOR completed\n");
+    return NULL;
+}
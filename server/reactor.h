@@ -0,0 +1,35 @@
+#ifndef SERPENT_REACTOR_H
+#define SERPENT_REACTOR_H
+
+#include <stdbool.h>
+#include "events.h"
+#include "protocol.h"
+#include "registry.h"
+
+// single epoll event loop owning the listening socket and all client sockets
+// replaces one recv thread per client, decodes messages and pushes events to main thread
+// also flushes clients' outbound queues when their sockets become writable again
+typedef struct {
+    int epoll_fd;
+    int wake_fd; // eventfd used to interrupt epoll_wait on shutdown
+    int listen_fd; // -1 when not accepting (single player)
+    EventQueue *eq;
+    ClientRegistry *reg;
+    size_t connection_count;
+} Reactor;
+
+typedef struct {
+    Reactor *reactor;
+    const _Atomic bool *running;
+} ReactorThreadArgs;
+
+int reactor_init(Reactor *r, EventQueue *eq, ClientRegistry *reg);
+void reactor_destroy(Reactor *r);
+
+int reactor_add_listener(Reactor *r, int listen_fd);
+int reactor_add_client(Reactor *r, Client *c);
+void reactor_stop(Reactor *r);
+
+void *reactor_thread(void *arg);
+
+#endif //SERPENT_REACTOR_H
@@ -1,83 +1,426 @@
+#define _POSIX_C_SOURCE 199309L
 #include "registry.h"
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include "logging.h"
+
+static void client_free(Client *c) {
+    close(c->socket_fd);
+    msg_reader_destroy(&c->reader);
+    outbound_destroy(&c->out);
+    free(c);
+}
+
+/**
+ * Gives a client's pending output a last chance to reach the socket.
+ *
+ * Used on shutdown so a final game over message queued for a slow
+ * client is not lost when its socket is closed.
+ *
+ * @param c         Pointer to the client.
+ * @param deadline  Absolute CLOCK_MONOTONIC time after which we give up.
+ */
+static void client_linger(Client *c, const struct timespec *deadline) {
+    pthread_mutex_lock(&c->out.lock);
+    while (outbound_flush(&c->out, c->socket_fd) == 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const long left_ms = (deadline->tv_sec - now.tv_sec) * 1000 +
+                             (deadline->tv_nsec - now.tv_nsec) / 1000000;
+        if (left_ms <= 0) break;
+
+        struct pollfd pfd = { .fd = c->socket_fd, .events = POLLOUT };
+        if (poll(&pfd, 1, (int)left_ms) <= 0) break;
+    }
+    pthread_mutex_unlock(&c->out.lock);
+}
+
+// copy of `from` (or empty list), reference held by the registry while published
+static ClientList *client_list_new(const ClientList *from) {
+    ClientList *l = malloc(sizeof(ClientList));
+    if (!l) return NULL;
+    if (from) {
+        memcpy(l->clients, from->clients, from->count * sizeof(Client *));
+        memcpy(l->by_slot, from->by_slot, sizeof(l->by_slot));
+        l->count = from->count;
+    } else {
+        memset(l->by_slot, 0, sizeof(l->by_slot));
+        l->count = 0;
+    }
+    atomic_init(&l->refs, 1);
+    return l;
+}
+
+static void client_unref(Client *c) {
+    if (atomic_fetch_sub_explicit(&c->refs, 1, memory_order_acq_rel) == 1) {
+        client_free(c);
+    }
+}
 
 void registry_init(ClientRegistry *r) {
-    r->capacity = 8;
-    r->count = 0;
-    r->clients = malloc(r->capacity * sizeof(Client *));
+    r->current = client_list_new(NULL);
+    handle_table_init(&r->handles);
     pthread_mutex_init(&r->lock, NULL);
 }
 
 void registry_destroy(ClientRegistry *r) {
-    for (size_t i = 0; i < r->count; ++i) {
-        Client *c = r->clients[i];
-        close(c->socket_fd);
-        pthread_join(c->thread, NULL);
-        free(c);
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += SHUTDOWN_LINGER_MS / 1000;
+    deadline.tv_nsec += (SHUTDOWN_LINGER_MS % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    ClientList *l = r->current;
+    r->current = NULL;
+    for (size_t i = 0; l && i < l->count; ++i) {
+        client_linger(l->clients[i], &deadline);
     }
-    free(r->clients);
+    registry_release(l); // frees clients once no reader holds them
     pthread_mutex_destroy(&r->lock);
 }
 
-// implicitly assumes lock is held when called
-static void registry_grow(ClientRegistry *r) {
-    const size_t new_capacity = r->capacity * 2;
-    Client **new_clients = realloc(r->clients, new_capacity * sizeof(Client *));
-    if (new_clients == NULL) {
-        return;
+/**
+ * Takes a reference to the currently published client list.
+ *
+ * The lock is held only to read the pointer and bump its reference count,
+ * the caller then iterates (and sends to) the clients without any lock.
+ * Every acquire must be paired with registry_release().
+ *
+ * @param r  Pointer to the client registry.
+ * @return Immutable client list snapshot.
+ */
+ClientList *registry_acquire(ClientRegistry *r) {
+    pthread_mutex_lock(&r->lock);
+    ClientList *l = r->current;
+    atomic_fetch_add_explicit(&l->refs, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&r->lock);
+    return l;
+}
+
+// drops a snapshot reference, last one releases its clients
+void registry_release(ClientList *l) {
+    if (!l) return;
+    if (atomic_fetch_sub_explicit(&l->refs, 1, memory_order_acq_rel) != 1) return;
+
+    for (size_t i = 0; i < l->count; ++i) {
+        client_unref(l->clients[i]);
     }
-    r->capacity = new_capacity;
-    r->clients = new_clients;
+    free(l);
 }
 
+// swaps in a new list, caller holds r->lock; old list is released after unlock
+static ClientList *registry_publish(ClientRegistry *r, ClientList *next) {
+    for (size_t i = 0; i < next->count; ++i) {
+        atomic_fetch_add_explicit(&next->clients[i]->refs, 1, memory_order_relaxed);
+    }
+    ClientList *old = r->current;
+    r->current = next;
+    return old;
+}
 
-void register_client(ClientRegistry *r, const int client_fd, const pthread_t thread) {
+Client *register_client(ClientRegistry *r, const int client_fd) {
     Client *c = malloc(sizeof(Client));
+    if (!c) return NULL;
     c->socket_fd = client_fd;
-    c->thread = thread;
+    c->epoll_fd = -1;
+    c->batched = false;
+    c->game_over = false;
+    atomic_init(&c->refs, 0);
+    msg_reader_init(&c->reader);
+    outbound_init(&c->out);
     // TODO assign and time_joined
 
     pthread_mutex_lock(&r->lock);
 
-    if (r->count == r->capacity)
-        registry_grow(r);
-
-    r->clients[r->count++] = c;
+    ClientList *next = NULL;
+    const bool have_slot = handle_alloc(&r->handles, &c->handle);
+    if (have_slot) next = client_list_new(r->current);
+    if (!next) {
+        if (have_slot) handle_release(&r->handles, c->handle);
+        pthread_mutex_unlock(&r->lock);
+        log_server(have_slot ? "FAILED: to register client\n" : "server full, client rejected\n");
+        msg_reader_destroy(&c->reader);
+        outbound_destroy(&c->out);
+        free(c);
+        return NULL;
+    }
+    next->clients[next->count++] = c;
+    next->by_slot[c->handle.slot] = c;
+    ClientList *old = registry_publish(r, next);
 
     pthread_mutex_unlock(&r->lock);
+
+    registry_release(old);
+    return c;
 }
 
-// implicitly assumes lock is held when called
-static size_t find_client(ClientRegistry *r, const int id) {
-    for (size_t i = 0; i < r->count; ++i) {
-        if (r->clients[i]->socket_fd == id) {
-            return i;
-        }
-    }
-    return (size_t)-1; // not found
+// O(1), stale handles (slot reused by a newer client) are rejected
+static Client *find_client(const ClientList *l, const PlayerHandle h) {
+    if (h.slot >= MAX_PLAYERS) return NULL;
+    Client *c = l->by_slot[h.slot];
+    return c && handle_eq(c->handle, h) ? c : NULL;
 }
 
-void remove_client(ClientRegistry *r, const int id) {
+// client's socket is closed once the last snapshot still listing it is released
+void remove_client(ClientRegistry *r, const PlayerHandle h) {
     pthread_mutex_lock(&r->lock);
 
-    const size_t idx = find_client(r, id);
-    if (idx == (size_t)-1) {
+    const Client *c = find_client(r->current, h);
+    ClientList *next = c ? client_list_new(r->current) : NULL;
+    if (!next) {
         pthread_mutex_unlock(&r->lock);
         return;
     }
+    for (size_t i = 0; i < next->count; ++i) {
+        if (next->clients[i] == c) {
+            next->clients[i] = next->clients[--next->count]; // swap-remove
+            break;
+        }
+    }
+    next->by_slot[h.slot] = NULL;
+    handle_release(&r->handles, h);
+    ClientList *old = registry_publish(r, next);
 
-    Client *removed = r->clients[idx];
+    pthread_mutex_unlock(&r->lock);
 
-    r->clients[idx] = r->clients[r->count - 1];
-    r->count--;
+    registry_release(old);
+}
 
-    pthread_mutex_unlock(&r->lock);
+/**
+ * Queues a message for the client with the given handle.
+ *
+ * @param r    Pointer to the client registry.
+ * @param h    Client's player handle.
+ * @param msg  Message to send, ownership of payload moves to the registry.
+ * @return 0 on success, -1 if the client is unknown or stalled.
+ */
+int registry_send(ClientRegistry *r, const PlayerHandle h, Message msg) {
+    ClientList *l = registry_acquire(r);
+
+    Client *c = find_client(l, h);
+    if (!c) {
+        registry_release(l);
+        message_destroy(&msg);
+        return -1;
+    }
+
+    const int rc = client_send(c, msg);
+    registry_release(l);
+    return rc;
+}
+
+/**
+ * Drops a snapshot that would reach a client after its game over.
+ *
+ * Snapshots are encoded on the encoder thread behind the tick thread, so
+ * one taken before a player died can be queued after that player's game
+ * over. A handle never rejoins a game, so everything sent to it after the
+ * game over is older than it and would only show the dead snake again.
+ *
+ * @param c    Pointer to the client, caller holds c->out.lock.
+ * @param msg  Message about to be queued, destroyed if dropped.
+ * @return true if the message was dropped.
+ */
+static bool client_drop_stale(Client *c, Message *msg) {
+    if (msg->type == MSG_GAME_OVER) {
+        c->game_over = true;
+        return false;
+    }
+    if (msg->type != MSG_STATE || !c->game_over) return false;
+    message_destroy(msg);
+    return true;
+}
+
+// asks reactor to (not) report writability, caller holds c->out.lock
+static void client_watch_writable(Client *c, const bool on) {
+    if (c->out.write_armed == on || c->epoll_fd < 0) return;
+
+    struct epoll_event ev = {
+        .events = EPOLLIN | EPOLLRDHUP | (on ? EPOLLOUT : 0),
+        .data.ptr = c,
+    };
+    // fails with ENOENT once reactor dropped the client, nothing to watch then
+    if (epoll_ctl(c->epoll_fd, EPOLL_CTL_MOD, c->socket_fd, &ev) == 0) {
+        c->out.write_armed = on;
+    }
+}
+
+/**
+ * Queues a message for a client and writes what the socket accepts now.
+ *
+ * Never blocks: whatever does not fit stays in the client's outbound queue
+ * and the reactor flushes it once the socket becomes writable. A client
+ * whose queue overflows with control messages is shut down, which the
+ * reactor then reports as a disconnect.
+ *
+ * @param c    Pointer to the client.
+ * @param msg  Message to send, ownership of payload moves to the queue.
+ * @return 0 on success, -1 if the client is stalled or the socket failed.
+ */
+int client_send(Client *c, Message msg) {
+    pthread_mutex_lock(&c->out.lock);
+    if (client_drop_stale(c, &msg)) {
+        pthread_mutex_unlock(&c->out.lock);
+        return 0;
+    }
+
+    if (outbound_push(&c->out, msg) < 0) {
+        pthread_mutex_unlock(&c->out.lock);
+        log_server("client outbound queue full, disconnecting slow client\n");
+        shutdown(c->socket_fd, SHUT_RDWR);
+        return -1;
+    }
+
+    const int rc = outbound_flush(&c->out, c->socket_fd);
+    client_watch_writable(c, rc == 0);
+
+    pthread_mutex_unlock(&c->out.lock);
+    return rc < 0 ? -1 : 0;
+}
+
+// reactor thread: socket became writable
+void client_flush(Client *c) {
+    pthread_mutex_lock(&c->out.lock);
+    const int rc = outbound_flush(&c->out, c->socket_fd);
+    client_watch_writable(c, rc == 0);
+    pthread_mutex_unlock(&c->out.lock);
+}
+
+/**
+ * Sets up the worker's send batch, with io_uring when the kernel offers it.
+ *
+ * @param b  Pointer to the batch.
+ */
+void send_batch_init(SendBatch *b) {
+    b->count = 0;
+    if (io_ring_init(&b->ring, MAX_PLAYERS)) {
+        log_server("output backend: io_uring\n");
+    } else {
+        log_server("output backend: writev\n");
+    }
+}
+
+void send_batch_destroy(SendBatch *b) {
+    send_batch_flush(b);
+    io_ring_destroy(&b->ring);
+}
 
-    close(removed->socket_fd);
-    pthread_join(removed->thread, NULL);
-    free(removed);
+/**
+ * Queues a message for a client, the write itself is left to send_batch_flush().
+ *
+ * @param r    Pointer to the client registry.
+ * @param h    Client's player handle.
+ * @param msg  Message to send, ownership of payload moves to the registry.
+ * @param b    Worker's send batch.
+ * @return 0 on success, -1 if the client is unknown or stalled.
+ */
+int registry_send_batched(ClientRegistry *r, const PlayerHandle h, Message msg, SendBatch *b) {
+    ClientList *l = registry_acquire(r);
+
+    Client *c = find_client(l, h);
+    if (!c) {
+        registry_release(l);
+        message_destroy(&msg);
+        return -1;
+    }
+
+    pthread_mutex_lock(&c->out.lock);
+    if (client_drop_stale(c, &msg)) {
+        pthread_mutex_unlock(&c->out.lock);
+        registry_release(l);
+        return 0;
+    }
+    const int rc = outbound_push(&c->out, msg);
+    pthread_mutex_unlock(&c->out.lock);
+
+    if (rc < 0) {
+        log_server("client outbound queue full, disconnecting slow client\n");
+        shutdown(c->socket_fd, SHUT_RDWR);
+    } else if (!c->batched) {
+        // removed clients stay in the batch until it is written, so churn can fill it before a drain ends
+        if (b->count == MAX_PLAYERS) send_batch_flush(b);
+        // keeps the socket open until the batch is written, even if the client is removed meanwhile
+        atomic_fetch_add_explicit(&c->refs, 1, memory_order_relaxed);
+        c->batched = true;
+        b->clients[b->count++] = c;
+    }
+
+    registry_release(l);
+    return rc;
 }
 
+/**
+ * Writes the output queued in the batch.
+ *
+ * With io_uring one sendmsg per client is submitted and completed by a
+ * single io_uring_enter() call, otherwise every client is flushed on its
+ * own. Clients whose send the ring did not queue or the kernel did not
+ * take are flushed on their own too, never one whose send was taken, so
+ * no byte goes out twice. Output a socket does not take is left to the
+ * reactor, as with client_send().
+ *
+ * @param b  Pointer to the batch.
+ */
+void send_batch_flush(SendBatch *b) {
+    if (b->count == 0) return;
+
+    const bool ringed = b->ring.fd >= 0;
+    if (ringed) {
+        size_t order[MAX_PLAYERS]; // queued sends in submission order
+        size_t queued = 0;
+
+        // queues stay locked while the kernel reads their buffers
+        for (size_t i = 0; i < b->count; ++i) {
+            Client *c = b->clients[i];
+            pthread_mutex_lock(&c->out.lock);
+            b->unsent[i] = false;
+            const int iovcnt = outbound_gather(&c->out, b->iov[i]);
+            if (iovcnt == 0) continue;
+            b->msg[i] = (struct msghdr){ .msg_iov = b->iov[i], .msg_iovlen = (size_t)iovcnt };
+            if (io_ring_sendmsg(&b->ring, c->socket_fd, &b->msg[i], i)) order[queued++] = i;
+            else b->unsent[i] = true;
+        }
+
+        // the kernel takes sends in order, the ones after those it took were dropped
+        const int taken = io_ring_submit(&b->ring);
+        for (size_t k = taken > 0 ? (size_t)taken : 0; k < queued; ++k) {
+            b->unsent[order[k]] = true;
+        }
+
+        uint64_t i;
+        int res;
+        while (io_ring_complete(&b->ring, &i, &res)) {
+            Client *c = b->clients[i];
+            if (res >= 0) outbound_advance(&c->out, (size_t)res);
+            const bool full = res == -EAGAIN || (res >= 0 && c->out.count > 0);
+            client_watch_writable(c, full);
+        }
+
+        for (size_t k = 0; k < b->count; ++k) {
+            pthread_mutex_unlock(&b->clients[k]->out.lock);
+        }
 
+        if (b->ring.error != 0) {
+            // what it did not take is written below, plain writes from now on
+            log_server("FAILED: io_uring submit, switching to writev\n");
+            io_ring_destroy(&b->ring);
+        }
+    }
 
+    for (size_t i = 0; i < b->count; ++i) {
+        Client *c = b->clients[i];
+        if (!ringed || b->unsent[i]) client_flush(c);
+        c->batched = false;
+        client_unref(c);
+    }
+    b->count = 0;
+}
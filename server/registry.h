@@ -2,25 +2,69 @@
 #define SERPENT_REGISTRY_H
 
 #include <pthread.h>
+#include <stdatomic.h>
+#include "protocol.h"
+#include "outbound.h"
+#include "handles.h"
+#include "uring.h"
 
 typedef struct Client {
-    int socket_fd;  // acts as unique identifier for client
+    int socket_fd;  // non-blocking socket
+    PlayerHandle handle; // unique identifier for client, assigned at accept
     int time_joined;
-    pthread_t thread;
+    int epoll_fd; // reactor watching this socket, used to request writability
+    _Atomic size_t refs; // one per client list holding it, socket closed when last one drops
+    MsgReader reader; // partially received message, reactor thread only
+    OutboundQueue out; // pending messages to this client
+    bool batched; // has output waiting in the worker's SendBatch, worker thread only
+    bool game_over; // game over queued, snapshots sent after it are stale and dropped, guarded by out.lock
 }   Client;
 
+// immutable snapshot of registered clients, shared by readers via reference count
 typedef struct {
-    Client **clients; // dynamic array of pointers to clients (safer memory management when shared)
+    _Atomic size_t refs;
     size_t count;
-    size_t capacity;
-    pthread_mutex_t lock;
+    Client *clients[MAX_PLAYERS]; // dense, for broadcasting (safer memory management when shared)
+    Client *by_slot[MAX_PLAYERS]; // indexed by handle slot, NULL if free
+} ClientList;
+
+// copy-on-write registry (RCU style): writers publish a new list, readers iterate
+// an acquired snapshot without holding any lock
+typedef struct {
+    ClientList *current; // latest published list
+    HandleTable handles; // guarded by lock
+    pthread_mutex_t lock; // serializes writers, readers only hold it to take a reference
 } ClientRegistry;
 
 void registry_init(ClientRegistry *r);
 void registry_destroy(ClientRegistry *r);
-static void registry_grow(ClientRegistry *r);
-void register_client(ClientRegistry *r, int client_fd, pthread_t thread); // main/accept thread responsibility
-void remove_client(ClientRegistry *r, int id); // worker thread responsibility
-static size_t find_client(ClientRegistry *r, int id);  // id is socket_fd here or some unique identifier
+Client *register_client(ClientRegistry *r, int client_fd); // main/reactor thread responsibility
+void remove_client(ClientRegistry *r, PlayerHandle h); // worker thread responsibility
+static Client *find_client(const ClientList *l, PlayerHandle h);
+
+ClientList *registry_acquire(ClientRegistry *r);
+void registry_release(ClientList *l);
+
+int registry_send(ClientRegistry *r, PlayerHandle h, Message msg);
+
+// output queued by the worker while it executes one batch of actions and
+// written afterwards, with io_uring all sockets at once in a single syscall
+typedef struct {
+    Client *clients[MAX_PLAYERS]; // clients with new output, referenced until flushed
+    size_t count;
+    IoRing ring; // fd -1 -> each client is flushed with its own writev()
+    struct iovec iov[MAX_PLAYERS][OUTBOUND_IOV_MAX]; // in flight buffers per batched client
+    struct msghdr msg[MAX_PLAYERS];
+    bool unsent[MAX_PLAYERS]; // output the ring did not take, written with writev() after it
+} SendBatch;
+
+void send_batch_init(SendBatch *b);
+void send_batch_destroy(SendBatch *b);
+int registry_send_batched(ClientRegistry *r, PlayerHandle h, Message msg, SendBatch *b);
+void send_batch_flush(SendBatch *b);
+
+// non-blocking output
+int client_send(Client *c, Message msg);
+void client_flush(Client *c);
 
-#endif //SERPENT_REGISTRY_H
\ No newline at end of file
+#endif //SERPENT_REGISTRY_H
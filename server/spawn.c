@@ -0,0 +1,115 @@
+#include "spawn.h"
+#include <limits.h>
+#include <stdlib.h>
+#include "config.h"
+#include "logging.h"
+
+int spawn_init(SpawnPlanner *s, const int width, const int height, const int length, const int clearance) {
+    const size_t n = (size_t)width * (size_t)height;
+    s->width = width;
+    s->height = height;
+    s->length = length;
+    s->clearance = clearance;
+    s->min_x = length - 1;
+    s->max_x = width - 1 - clearance;
+
+    // board starts empty, nothing blocked and every head whose window fits is ready
+    s->ready = (CellSet){0};
+    s->blocked = calloc(n, sizeof(uint16_t));
+    if (!s->blocked || cell_set_init(&s->ready, width, height, s->min_x, s->max_x, 0, height - 1) < 0) {
+        log_server("FAILED: to allocate spawn planner\n");
+        spawn_destroy(s);
+        return -1;
+    }
+    return 0;
+}
+
+void spawn_destroy(SpawnPlanner *s) {
+    free(s->blocked);
+    s->blocked = NULL;
+    cell_set_destroy(&s->ready);
+}
+
+/**
+ * Updates the heads whose window covers a cell that became occupied or empty.
+ *
+ * A cell lies in the windows of the heads from `clearance` cells to its
+ * left up to `length - 1` cells to its right on the same row, so one
+ * change touches length + clearance counters.
+ *
+ * @param s         Pointer to the planner.
+ * @param p         Cell that changed, must be on the board.
+ * @param occupied  true if something is on it now, false if it became empty.
+ */
+void spawn_cell_changed(SpawnPlanner *s, const Position p, const bool occupied) {
+    int from = p.x - s->clearance;
+    int to = p.x + s->length - 1;
+    if (from < s->min_x) from = s->min_x;
+    if (to > s->max_x) to = s->max_x;
+
+    const size_t row = (size_t)p.y * (size_t)s->width;
+    for (int x = from; x <= to; ++x) {
+        const size_t i = row + (size_t)x;
+        if (occupied) {
+            if (s->blocked[i]++ == 0) cell_set_remove(&s->ready, i);
+        } else {
+            if (--s->blocked[i] == 0) cell_set_add(&s->ready, i);
+        }
+    }
+}
+
+// chebyshev distance from the nearest live head to a window (body plus clearance ahead)
+static int window_distance(const SpawnPlanner *s, const Position head, const Position *heads,
+                           const size_t head_count) {
+    const int lo = head.x - (s->length - 1);
+    const int hi = head.x + s->clearance;
+    int best = INT_MAX;
+    for (size_t k = 0; k < head_count; ++k) {
+        const Position q = heads[k];
+        int dx = 0;
+        if (q.x < lo) dx = lo - q.x;
+        else if (q.x > hi) dx = q.x - hi;
+        const int dy = abs(q.y - head.y);
+        const int d = dx > dy ? dx : dy;
+        if (d < best) best = d;
+    }
+    return best;
+}
+
+/**
+ * Picks a head cell whose whole window is empty and away from live heads.
+ *
+ * Up to SPAWN_CANDIDATES places are drawn from the clear set (all of them
+ * when there are no more than that) and scored by their distance to the
+ * nearest live head. The first one farther than `radius` is taken, so on
+ * an open board this is a single O(head_count) check; otherwise the
+ * farthest candidate is, so a crowded board still gets the best place seen.
+ *
+ * @param s           Pointer to the planner.
+ * @param heads       Head positions of the snakes in play.
+ * @param head_count  Number of heads.
+ * @param radius      Cells to keep between the new snake and any head, 0 for none.
+ * @param head        Receives the head position, the body extends to the left.
+ * @return true on success, false if no snake fits anywhere on the map.
+ */
+bool spawn_pick(const SpawnPlanner *s, const Position *heads, const size_t head_count, const int radius,
+                Position *head) {
+    const size_t count = s->ready.count;
+    if (count == 0) return false;
+
+    const bool every = count <= SPAWN_CANDIDATES;
+    const size_t tries = every ? count : SPAWN_CANDIDATES;
+    const size_t start = (size_t)rand() % count;
+    int best_score = -1;
+    for (size_t t = 0; t < tries; ++t) {
+        const size_t i = cell_set_at(&s->ready, every ? (start + t) % count : (size_t)rand() % count);
+        const Position p = { (int)(i % (size_t)s->width), (int)(i / (size_t)s->width) };
+        const int score = window_distance(s, p, heads, head_count);
+        if (score > best_score) {
+            best_score = score;
+            *head = p;
+        }
+        if (score > radius) break;
+    }
+    return true;
+}
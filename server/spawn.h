@@ -0,0 +1,33 @@
+#ifndef SERPENT_SPAWN_H
+#define SERPENT_SPAWN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+#include "cellset.h"
+
+// spawn planner: every head cell a joining snake could start on (facing right) has a
+// window of `length` body cells behind it and `clearance` cells ahead of it, the count of
+// occupied cells in that window is kept up to date as cells fill and empty, and heads
+// whose window is clear sit in a dense set, so a join picks one in O(1); a few of those are
+// then scored by how far they are from the heads of live snakes
+typedef struct {
+    int width;
+    int height;
+    int length; // body cells of a new snake
+    int clearance; // empty cells required in front of a new head
+    int min_x; // head columns whose window fits on the board
+    int max_x;
+
+    uint16_t *blocked; // head cell -> occupied cells in its window
+    CellSet ready; // head cells with a clear window, starts as every head whose window fits
+} SpawnPlanner;
+
+int spawn_init(SpawnPlanner *s, int width, int height, int length, int clearance);
+void spawn_destroy(SpawnPlanner *s);
+
+void spawn_cell_changed(SpawnPlanner *s, Position p, bool occupied);
+bool spawn_pick(const SpawnPlanner *s, const Position *heads, size_t head_count, int radius, Position *head);
+
+#endif //SERPENT_SPAWN_H
@@ -0,0 +1,209 @@
+#define _POSIX_C_SOURCE 199309L
+#include "timers.h"
+#include <stdlib.h>
+#include "logging.h"
+
+#define WHEEL_MASK ((uint64_t)TIMER_WHEEL_SLOTS - 1)
+
+static uint64_t wheel_clock_ms(const TimerWheel *w, const struct timespec *now) {
+    return (uint64_t)(now->tv_sec - w->start.tv_sec) * 1000ULL +
+           (uint64_t)((now->tv_nsec - w->start.tv_nsec) / 1000000L);
+}
+
+void timer_wheel_init(TimerWheel *w) {
+    w->nodes = malloc(MAX_TIMERS * sizeof(TimerNode));
+    if (!w->nodes) {
+        log_server("FAILED: to allocate timer wheel nodes\n");
+    }
+
+    // chain every node into the free list
+    w->free_head = w->nodes ? 0 : -1;
+    for (int i = 0; w->nodes && i < MAX_TIMERS; ++i) {
+        w->nodes[i].next = i + 1 < MAX_TIMERS ? i + 1 : -1;
+    }
+
+    for (int l = 0; l < TIMER_WHEEL_LEVELS; ++l) {
+        for (int s = 0; s < TIMER_WHEEL_SLOTS; ++s) {
+            w->slots[l][s] = -1;
+        }
+    }
+
+    w->expired_head = -1;
+    w->expired_tail = -1;
+    w->pending = 0;
+    w->now_ms = 0;
+    clock_gettime(CLOCK_MONOTONIC, &w->start);
+}
+
+void timer_wheel_destroy(TimerWheel *w) {
+    free(w->nodes);
+    w->nodes = NULL;
+    w->pending = 0;
+}
+
+// links node into the slot matching its distance from current wheel time
+static void wheel_insert(TimerWheel *w, const int idx) {
+    TimerNode *n = &w->nodes[idx];
+    uint64_t delta = n->expires > w->now_ms ? n->expires - w->now_ms : 0;
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (uint64_t)1 << (TIMER_WHEEL_BITS * (level + 1))) {
+        level++;
+    }
+
+    // delays beyond wheel range are clamped to the furthest slot (~4.6 h)
+    const uint64_t max_delta = ((uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+    if (delta > max_delta) {
+        delta = max_delta;
+        n->expires = w->now_ms + delta;
+    }
+
+    const int slot = (int)((n->expires >> (TIMER_WHEEL_BITS * level)) & WHEEL_MASK);
+    n->next = w->slots[level][slot];
+    w->slots[level][slot] = idx;
+}
+
+// moves every timer from a higher level slot down to where it belongs now
+// returns slot index so caller knows whether the next level wrapped too
+static int wheel_cascade(TimerWheel *w, const int level) {
+    const int slot = (int)((w->now_ms >> (TIMER_WHEEL_BITS * level)) & WHEEL_MASK);
+    int idx = w->slots[level][slot];
+    w->slots[level][slot] = -1;
+
+    while (idx != -1) {
+        const int next = w->nodes[idx].next;
+        wheel_insert(w, idx);
+        idx = next;
+    }
+    return slot;
+}
+
+static void wheel_expire_slot(TimerWheel *w, const int slot) {
+    int idx = w->slots[0][slot];
+    w->slots[0][slot] = -1;
+
+    while (idx != -1) {
+        const int next = w->nodes[idx].next;
+        w->nodes[idx].next = -1;
+        w->pending--;
+
+        if (w->expired_tail == -1) {
+            w->expired_head = idx;
+        } else {
+            w->nodes[w->expired_tail].next = idx;
+        }
+        w->expired_tail = idx;
+
+        idx = next;
+    }
+}
+
+/**
+ * Schedules an event to be delivered after the given delay.
+ *
+ * O(1), no allocation: nodes come from a fixed pool sized by MAX_TIMERS.
+ * Delay has 1 ms resolution and is measured from the last wheel advance.
+ *
+ * @param w         Pointer to the timer wheel.
+ * @param delay_ms  Delay in milliseconds.
+ * @param ev        Event delivered by timer_wheel_pop_expired() on expiry.
+ * @return true on success, false if all timer nodes are in use.
+ */
+bool timer_wheel_schedule(TimerWheel *w, const uint64_t delay_ms, const Event ev) {
+    if (w->free_head == -1) {
+        log_server("FAILED: timer wheel full\n");
+        return false;
+    }
+
+    const int idx = w->free_head;
+    w->free_head = w->nodes[idx].next;
+
+    w->nodes[idx].expires = w->now_ms + (delay_ms > 0 ? delay_ms : 1);
+    w->nodes[idx].ev = ev;
+    wheel_insert(w, idx);
+    w->pending++;
+    return true;
+}
+
+/**
+ * Advances the wheel to the given monotonic time.
+ *
+ * Walks the elapsed milliseconds, cascading higher levels whenever a lower
+ * level wraps, and moves every due timer to the expired list. When nothing
+ * is pending the wheel just jumps to the given time.
+ *
+ * @param w    Pointer to the timer wheel.
+ * @param now  CLOCK_MONOTONIC time, usually the start of the current tick.
+ */
+void timer_wheel_advance(TimerWheel *w, const struct timespec *now) {
+    const uint64_t target = wheel_clock_ms(w, now);
+
+    if (w->pending == 0) {
+        if (target > w->now_ms) w->now_ms = target;
+        return;
+    }
+
+    while (w->now_ms < target && w->pending > 0) {
+        w->now_ms++;
+
+        const int slot = (int)(w->now_ms & WHEEL_MASK);
+        if (slot == 0) {
+            // level 0 wrapped, pull timers down from the levels above
+            for (int l = 1; l < TIMER_WHEEL_LEVELS; ++l) {
+                if (wheel_cascade(w, l) != 0) break;
+            }
+        }
+        wheel_expire_slot(w, slot);
+    }
+
+    if (w->now_ms < target) w->now_ms = target;
+}
+
+// pops next fired timer in expiry order, node returns to the free list
+bool timer_wheel_pop_expired(TimerWheel *w, Event *ev) {
+    const int idx = w->expired_head;
+    if (idx == -1) return false;
+
+    w->expired_head = w->nodes[idx].next;
+    if (w->expired_head == -1) w->expired_tail = -1;
+
+    *ev = w->nodes[idx].ev;
+
+    w->nodes[idx].next = w->free_head;
+    w->free_head = idx;
+    return true;
+}
+
+/**
+ * Finds when the earliest pending timer expires.
+ *
+ * Walks every slot, so it is meant for the idle path (deciding how long the
+ * game loop may sleep), not for every tick.
+ *
+ * @param w   Pointer to the timer wheel.
+ * @param at  Receives the CLOCK_MONOTONIC expiry time, in the past if fired timers wait to be popped.
+ * @return true if a timer is pending or fired, false if the wheel is empty.
+ */
+bool timer_wheel_next_expiry(const TimerWheel *w, struct timespec *at) {
+    uint64_t earliest = UINT64_MAX;
+    if (w->expired_head != -1) earliest = w->now_ms;
+
+    for (int l = 0; l < TIMER_WHEEL_LEVELS && w->pending > 0; ++l) {
+        for (int s = 0; s < TIMER_WHEEL_SLOTS; ++s) {
+            for (int idx = w->slots[l][s]; idx != -1; idx = w->nodes[idx].next) {
+                if (w->nodes[idx].expires < earliest) earliest = w->nodes[idx].expires;
+            }
+        }
+    }
+    if (earliest == UINT64_MAX) return false;
+
+    *at = w->start;
+    at->tv_sec += (time_t)(earliest / 1000);
+    at->tv_nsec += (long)(earliest % 1000) * 1000000L;
+    if (at->tv_nsec >= 1000000000L) {
+        at->tv_sec++;
+        at->tv_nsec -= 1000000000L;
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef SERPENT_TIMERS_H
+#define SERPENT_TIMERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "events.h"
+
+// hierarchical timer wheel owned by the main (tick) thread
+// 4 levels of 64 slots with 1 ms resolution -> covers delays up to 64^4 ms (~4.6 h)
+// timers deliver an Event back to the game loop when they expire
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+typedef struct {
+    uint64_t expires; // absolute wheel time in ms
+    Event ev; // delivered on expiry
+    int next; // index of next node in same slot/list, -1 terminates
+} TimerNode;
+
+typedef struct {
+    TimerNode *nodes; // fixed pool of MAX_TIMERS nodes
+    int free_head; // free list of nodes
+    int slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS]; // list heads, -1 empty
+    int expired_head; // fired timers waiting to be popped (FIFO)
+    int expired_tail;
+    uint64_t now_ms; // wheel time already processed
+    struct timespec start; // wheel time 0
+    size_t pending; // timers still in the wheel (not yet expired)
+} TimerWheel;
+
+void timer_wheel_init(TimerWheel *w);
+void timer_wheel_destroy(TimerWheel *w);
+
+bool timer_wheel_schedule(TimerWheel *w, uint64_t delay_ms, Event ev);
+void timer_wheel_advance(TimerWheel *w, const struct timespec *now);
+bool timer_wheel_pop_expired(TimerWheel *w, Event *ev);
+bool timer_wheel_next_expiry(const TimerWheel *w, struct timespec *at);
+
+#endif //SERPENT_TIMERS_H
@@ -0,0 +1,280 @@
+#define _GNU_SOURCE // cpu_set_t, pthread_setaffinity_np
+#include "tuning.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "config.h"
+#include "logging.h"
+
+#define DEFAULT_RT_PRIORITY 10
+
+void sched_options_init(SchedOptions *o) {
+    o->tick_cpus = NULL;
+    o->worker_cpus = NULL;
+    o->io_cpus = NULL;
+    o->realtime = false;
+    o->rt_priority = DEFAULT_RT_PRIORITY;
+}
+
+/**
+ * Parses one `--` command line option into the tuning options.
+ *
+ * @param o    Pointer to the options.
+ * @param arg  Argument starting with "--" (value after '=', kept by pointer).
+ * @return 1 if consumed, 0 if not a known option, -1 if its value is invalid.
+ */
+int sched_parse_option(SchedOptions *o, const char *arg) {
+    const char *eq = strchr(arg, '=');
+    const char *value = eq ? eq + 1 : NULL;
+    const size_t name_len = eq ? (size_t)(eq - arg) : strlen(arg);
+
+    if (name_len == strlen("--tick-cpus") && strncmp(arg, "--tick-cpus", name_len) == 0) {
+        o->tick_cpus = value;
+    } else if (name_len == strlen("--worker-cpus") && strncmp(arg, "--worker-cpus", name_len) == 0) {
+        o->worker_cpus = value;
+    } else if (name_len == strlen("--io-cpus") && strncmp(arg, "--io-cpus", name_len) == 0) {
+        o->io_cpus = value;
+    } else if (strcmp(arg, "--realtime") == 0) {
+        o->realtime = true;
+        return 1;
+    } else if (name_len == strlen("--rt-priority") && strncmp(arg, "--rt-priority", name_len) == 0) {
+        char *end = NULL;
+        const long prio = value ? strtol(value, &end, 10) : -1;
+        if (!value || *end != '\0' || prio < 1 || prio > 99) return -1;
+        o->rt_priority = (int)prio;
+        o->realtime = true;
+        return 1;
+    } else {
+        return 0;
+    }
+
+    return value && *value ? 1 : -1; // cpu list options need a value
+}
+
+void sched_usage(const char *prog) {
+    fprintf(stderr, "Tuning options for %s (may appear anywhere):\n"
+                    "  --tick-cpus=LIST    pin game loop thread, LIST like 2 or 0-1,4\n"
+                    "  --worker-cpus=LIST  pin action worker thread\n"
+                    "  --io-cpus=LIST      pin reactor (socket I/O) thread\n"
+                    "  --realtime          run game loop under SCHED_FIFO and lock memory\n"
+                    "  --rt-priority=N     SCHED_FIFO priority 1-99 (implies --realtime, default %d)\n",
+            prog, DEFAULT_RT_PRIORITY);
+}
+
+// "0-2,5" -> {0,1,2,5}
+static int parse_cpu_list(const char *list, cpu_set_t *set) {
+    CPU_ZERO(set);
+    const char *p = list;
+    while (*p) {
+        char *end = NULL;
+        const long first = strtol(p, &end, 10);
+        if (end == p || first < 0) return -1;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) return -1;
+            p = end;
+        }
+        if (last >= CPU_SETSIZE) return -1;
+        for (long cpu = first; cpu <= last; ++cpu) {
+            CPU_SET((int)cpu, set);
+        }
+        if (*p == ',') p++;
+        else if (*p != '\0') return -1;
+    }
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+/**
+ * Restricts a thread to the given CPUs.
+ *
+ * Failures are logged and otherwise ignored, the thread keeps running
+ * wherever the kernel puts it.
+ *
+ * @param thread  Thread to pin.
+ * @param cpus    CPU list, NULL leaves the thread unpinned.
+ * @param name    Thread name for the log.
+ * @return 0 if pinned or nothing to do, -1 on failure.
+ */
+int pin_thread(const pthread_t thread, const char *cpus, const char *name) {
+    if (!cpus) return 0;
+
+    char buf[128];
+    cpu_set_t set;
+    if (parse_cpu_list(cpus, &set) < 0) {
+        snprintf(buf, sizeof buf, "invalid cpu list '%s' for %s thread, not pinned\n", cpus, name);
+        log_server(buf);
+        return -1;
+    }
+
+    const int rc = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (rc != 0) {
+        snprintf(buf, sizeof buf, "FAILED: to pin %s thread to cpus %s: %s\n", name, cpus, strerror(rc));
+        log_server(buf);
+        return -1;
+    }
+
+    snprintf(buf, sizeof buf, "%s thread pinned to cpus %s\n", name, cpus);
+    log_server(buf);
+    return 0;
+}
+
+/**
+ * Switches the calling thread to SCHED_FIFO and locks process memory.
+ *
+ * Must be called after the other threads are created so they keep the
+ * normal policy. Missing permissions (no CAP_SYS_NICE / RLIMIT_RTPRIO or
+ * RLIMIT_MEMLOCK) are logged and the server continues with normal
+ * scheduling; each step falls back on its own.
+ *
+ * @param priority  SCHED_FIFO priority (1-99).
+ * @return true if the thread runs under SCHED_FIFO.
+ */
+bool enable_realtime(const int priority) {
+    char buf[128];
+
+    // avoid page faults in the tick (memory of all threads, current and future)
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        snprintf(buf, sizeof buf, "mlockall failed (%s), continuing without locked memory\n", strerror(errno));
+        log_server(buf);
+    } else {
+        log_server("memory locked\n");
+    }
+
+    const struct sched_param param = { .sched_priority = priority };
+    const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        snprintf(buf, sizeof buf, "SCHED_FIFO unavailable (%s), tick thread keeps normal scheduling\n", strerror(rc));
+        log_server(buf);
+        return false;
+    }
+
+    snprintf(buf, sizeof buf, "tick thread running SCHED_FIFO priority %d\n", priority);
+    log_server(buf);
+    return true;
+}
+
+void tick_jitter_init(TickJitter *j) {
+    memset(j, 0, sizeof(*j));
+}
+
+// called at the start of every tick with how late it started (TickClock.late_ns)
+void tick_jitter_record(TickJitter *j, const int64_t late_ns) {
+    const uint64_t late = late_ns > 0 ? (uint64_t)late_ns : 0;
+    const uint64_t bucket = late / (TICK_JITTER_BUCKET_US * 1000ULL);
+
+    if (bucket < TICK_JITTER_BUCKETS) j->buckets[bucket]++;
+    else j->overflow++;
+    if (late > j->max_ns) j->max_ns = late;
+    j->ticks++;
+}
+
+// upper bound of the bucket holding the given fraction of ticks, in microseconds
+static double jitter_percentile_us(const TickJitter *j, const double fraction) {
+    const uint64_t rank = (uint64_t)((double)j->ticks * fraction);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < TICK_JITTER_BUCKETS; ++i) {
+        seen += j->buckets[i];
+        if (seen > rank) return (double)((i + 1) * TICK_JITTER_BUCKET_US);
+    }
+    return (double)j->max_ns / 1000.0;
+}
+
+void tick_jitter_log(const TickJitter *j, const TickClock *clock) {
+    char buf[256];
+    if (j->ticks == 0) {
+        log_server("tick jitter: no ticks recorded\n");
+        return;
+    }
+    snprintf(buf, sizeof buf, "tick jitter over %llu ticks: p50 %.0f us, p90 %.0f us, p99 %.0f us, "
+             "p99.9 %.0f us, max %.0f us\n", (unsigned long long)j->ticks,
+             jitter_percentile_us(j, 0.50), jitter_percentile_us(j, 0.90), jitter_percentile_us(j, 0.99),
+             jitter_percentile_us(j, 0.999), (double)j->max_ns / 1000.0);
+    log_server(buf);
+
+    snprintf(buf, sizeof buf, "tick clock: %llu overruns, %llu ticks skipped\n",
+             (unsigned long long)clock->overruns, (unsigned long long)clock->skipped);
+    log_server(buf);
+}
+
+void snapshot_rate_init(SnapshotRate *r, const bool adaptive, const int64_t budget_ns) {
+    memset(r, 0, sizeof(*r));
+    r->adaptive = adaptive;
+    r->every = 1;
+    r->budget_ns = budget_ns;
+}
+
+// counts a non-idle tick, true if it should broadcast a snapshot
+bool snapshot_rate_due(SnapshotRate *r) {
+    return r->paced++ % r->every == 0;
+}
+
+/**
+ * Feeds the cost of a finished tick into the adaptive snapshot rate.
+ *
+ * Cost is smoothed (1/8 weight per tick). When it climbs above
+ * SNAPSHOT_SHED_PERCENT of the tick budget every other, third ... snapshot
+ * is skipped (up to SNAPSHOT_MAX_EVERY), below SNAPSHOT_RESTORE_PERCENT
+ * the rate steps back up. After a change the rate is held for
+ * SNAPSHOT_HOLD_TICKS so the effect can show in the cost.
+ *
+ * Every tick run is counted here, idle or not, for the rates logged at
+ * shutdown.
+ *
+ * @param r        Pointer to the snapshot rate.
+ * @param cost_ns  Time the tick spent working (not sleeping).
+ * @param idle     Whether the tick ended with nothing able to move.
+ * @param sent     Whether the tick published a snapshot.
+ */
+void snapshot_rate_record(SnapshotRate *r, const int64_t cost_ns, const bool idle, const bool sent) {
+    r->ticks++;
+    if (idle) r->idle_ticks++;
+    if (sent) r->sent++;
+    r->cost_ns += (cost_ns - r->cost_ns) / 8;
+    if (!r->adaptive) return;
+    if (r->hold > 0) {
+        r->hold--;
+        return;
+    }
+
+    unsigned every = r->every;
+    if (r->cost_ns * 100 > r->budget_ns * SNAPSHOT_SHED_PERCENT && every < SNAPSHOT_MAX_EVERY) every++;
+    else if (r->cost_ns * 100 < r->budget_ns * SNAPSHOT_RESTORE_PERCENT && every > 1) every--;
+    if (every == r->every) return;
+
+    char buf[128];
+    snprintf(buf, sizeof buf, "tick cost %lld us of %lld us budget, snapshot every %u ticks\n",
+             (long long)(r->cost_ns / 1000), (long long)(r->budget_ns / 1000), every);
+    log_server(buf);
+    r->every = every;
+    r->hold = SNAPSHOT_HOLD_TICKS;
+    r->changes++;
+}
+
+/**
+ * Logs configured against effective rates.
+ *
+ * Effective rates are the ticks actually run and the snapshots actually
+ * sent over the wall time of the game, so ticks skipped while idle (asleep)
+ * or dropped after a late one lower them; idle ticks are counted apart.
+ *
+ * @param r            Pointer to the snapshot rate.
+ * @param tick_rate    Configured ticks per second.
+ * @param elapsed_sec  Wall time the game loop ran.
+ */
+void snapshot_rate_log(const SnapshotRate *r, const int tick_rate, const double elapsed_sec) {
+    char buf[320];
+    if (elapsed_sec <= 0.0) return;
+    const double expected = (double)tick_rate * elapsed_sec;
+    const double not_run = expected > (double)r->ticks ? expected - (double)r->ticks : 0.0;
+    snprintf(buf, sizeof buf, "rates: tick %d/s configured, %.1f/s effective (%llu run in %.1f s, %llu idle, "
+             "%.0f not run); snapshots %.1f/s (adaptive %d, %llu changes, now every %u ticks), tick cost %lld us\n",
+             tick_rate, (double)r->ticks / elapsed_sec, (unsigned long long)r->ticks, elapsed_sec,
+             (unsigned long long)r->idle_ticks, not_run, (double)r->sent / elapsed_sec, r->adaptive ? 1 : 0,
+             (unsigned long long)r->changes, r->every, (long long)(r->cost_ns / 1000));
+    log_server(buf);
+}
@@ -0,0 +1,63 @@
+#ifndef SERPENT_TUNING_H
+#define SERPENT_TUNING_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "timer.h"
+
+// optional scheduling setup for shared hosts (all off by default)
+// cpu lists use the taskset/cpuset syntax, e.g. "2" or "0-1,4"
+typedef struct {
+    const char *tick_cpus; // main (game loop) thread, NULL = not pinned
+    const char *worker_cpus;
+    const char *io_cpus; // reactor thread
+    bool realtime; // SCHED_FIFO + mlockall for the tick thread
+    int rt_priority;
+} SchedOptions;
+
+void sched_options_init(SchedOptions *o);
+int sched_parse_option(SchedOptions *o, const char *arg);
+void sched_usage(const char *prog);
+
+int pin_thread(pthread_t thread, const char *cpus, const char *name);
+bool enable_realtime(int priority);
+
+// tick lateness histogram (main thread only)
+// bucket i counts ticks that started [i, i+1) * TICK_JITTER_BUCKET_US after their deadline
+#define TICK_JITTER_BUCKET_US 10
+#define TICK_JITTER_BUCKETS 10000 // up to 100 ms, anything above goes to overflow
+
+typedef struct {
+    uint32_t buckets[TICK_JITTER_BUCKETS];
+    uint32_t overflow;
+    uint64_t ticks;
+    uint64_t max_ns;
+} TickJitter;
+
+void tick_jitter_init(TickJitter *j);
+void tick_jitter_record(TickJitter *j, int64_t late_ns);
+void tick_jitter_log(const TickJitter *j, const TickClock *clock);
+
+// snapshot send rate (main thread only), simulation keeps ticking at full rate
+// in adaptive mode snapshots go out every `every`-th tick while the smoothed tick
+// cost stays above SNAPSHOT_SHED_PERCENT of the budget and come back below SNAPSHOT_RESTORE_PERCENT
+typedef struct {
+    bool adaptive;
+    unsigned every; // 1 = snapshot on every tick
+    unsigned hold; // ticks before the rate may change again
+    int64_t budget_ns; // tick period
+    int64_t cost_ns; // smoothed tick cost
+    uint64_t paced; // non-idle ticks, every `every`-th of them broadcasts
+    uint64_t ticks; // ticks run
+    uint64_t idle_ticks; // ticks that ended with nothing able to move
+    uint64_t sent; // ticks that broadcast a snapshot, idle heartbeats included
+    uint64_t changes;
+} SnapshotRate;
+
+void snapshot_rate_init(SnapshotRate *r, bool adaptive, int64_t budget_ns);
+bool snapshot_rate_due(SnapshotRate *r);
+void snapshot_rate_record(SnapshotRate *r, int64_t cost_ns, bool idle, bool sent);
+void snapshot_rate_log(const SnapshotRate *r, int tick_rate, double elapsed_sec);
+
+#endif //SERPENT_TUNING_H
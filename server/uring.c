@@ -0,0 +1,217 @@
+#define _GNU_SOURCE
+#include "uring.h"
+
+#ifdef SERPENT_HAVE_IO_URING
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+static int sys_io_uring_setup(const unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(const int fd, const unsigned to_submit, const unsigned min_complete,
+                              const unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+/**
+ * Creates an io_uring instance and maps its submission and completion rings.
+ *
+ * @param r        Pointer to the ring to initialize.
+ * @param entries  Submission queue size, most entries in flight at once.
+ * @return true on success, false if io_uring is not available (r->fd is -1).
+ */
+bool io_ring_init(IoRing *r, const unsigned entries) {
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    const int fd = sys_io_uring_setup(entries, &p);
+    if (fd < 0) return false;
+
+    r->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && r->cq_map_len > r->sq_map_len) r->sq_map_len = r->cq_map_len;
+
+    r->sq_map = mmap(NULL, r->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, IORING_OFF_SQ_RING);
+    if (r->sq_map == MAP_FAILED) goto fail_sq;
+
+    if (single) {
+        r->cq_map = r->sq_map;
+    } else {
+        r->cq_map = mmap(NULL, r->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_CQ_RING);
+        if (r->cq_map == MAP_FAILED) goto fail_cq;
+    }
+
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) goto fail_sqes;
+
+    char *sq = r->sq_map;
+    r->sq_head = (_Atomic unsigned *)(sq + p.sq_off.head);
+    r->sq_tail = (_Atomic unsigned *)(sq + p.sq_off.tail);
+    r->sq_mask = *(unsigned *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(sq + p.sq_off.array);
+
+    char *cq = r->cq_map;
+    r->cq_head = (_Atomic unsigned *)(cq + p.cq_off.head);
+    r->cq_tail = (_Atomic unsigned *)(cq + p.cq_off.tail);
+    r->cq_mask = *(unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    r->fd = fd;
+    return true;
+
+fail_sqes:
+    if (!single) munmap(r->cq_map, r->cq_map_len);
+fail_cq:
+    munmap(r->sq_map, r->sq_map_len);
+fail_sq:
+    close(fd);
+    return false;
+}
+
+void io_ring_destroy(IoRing *r) {
+    if (r->fd < 0) return;
+    munmap(r->sqes, r->sqes_len);
+    if (r->cq_map != r->sq_map) munmap(r->cq_map, r->cq_map_len);
+    munmap(r->sq_map, r->sq_map_len);
+    close(r->fd);
+    r->fd = -1;
+}
+
+/**
+ * Prepares a non-blocking send of a message, submitted by the next io_ring_submit().
+ *
+ * MSG_DONTWAIT is added so a full socket completes with -EAGAIN instead of
+ * parking the entry in the kernel (io_uring ignores O_NONBLOCK on sockets).
+ * The message header, its iovecs and the memory they point to must stay
+ * valid until the entry's completion has been taken with io_ring_complete().
+ *
+ * @param r    Pointer to the ring.
+ * @param fd   Socket to write to.
+ * @param msg  Buffers to send.
+ * @param tag  Value reported back with the completion.
+ * @return true if queued, false if the submission ring is full.
+ */
+bool io_ring_sendmsg(IoRing *r, const int fd, const struct msghdr *msg, const uint64_t tag) {
+    const unsigned tail = atomic_load_explicit(r->sq_tail, memory_order_relaxed);
+    const unsigned head = atomic_load_explicit(r->sq_head, memory_order_acquire);
+    if (tail - head > r->sq_mask) return false;
+
+    const unsigned idx = tail & r->sq_mask;
+    struct io_uring_sqe *sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+    sqe->user_data = tag;
+    r->sq_array[idx] = idx;
+
+    atomic_store_explicit(r->sq_tail, tail + 1, memory_order_release);
+    r->queued++;
+    return true;
+}
+
+/**
+ * Submits all prepared entries and waits until every submitted one has completed.
+ *
+ * Sockets are non-blocking, so the kernel answers each write right away
+ * (possibly with -EAGAIN); the whole batch costs one system call.
+ * The kernel takes entries in the order they were prepared. If
+ * io_uring_enter() fails part way, the entries it has not taken are
+ * dropped unread and the ones it took are still waited for; the error is
+ * kept in r->error.
+ *
+ * @param r  Pointer to the ring.
+ * @return Number of entries taken, the first ones prepared (their completions
+ *         are ready), -1 if the kernel took none because of an error.
+ */
+int io_ring_submit(IoRing *r) {
+    unsigned want = r->queued;
+    unsigned left = want;
+    r->queued = 0;
+
+    while (left > 0 ||
+           atomic_load_explicit(r->cq_tail, memory_order_acquire) -
+           atomic_load_explicit(r->cq_head, memory_order_relaxed) < want) {
+        const int n = sys_io_uring_enter(r->fd, left, want, IORING_ENTER_GETEVENTS);
+        if (n >= 0) {
+            left -= (unsigned)n;
+            continue;
+        }
+        if (errno == EINTR) continue;
+
+        r->error = errno;
+        if (left == 0) break; // cannot wait anymore, completions not in yet are never reported
+        // no SQ polling, the kernel only reads the tail inside io_uring_enter(), so it can be pulled back
+        atomic_store_explicit(r->sq_tail, atomic_load_explicit(r->sq_head, memory_order_acquire),
+                              memory_order_release);
+        want -= left;
+        left = 0;
+    }
+    if (want == 0 && r->error != 0) return -1;
+    return (int)want;
+}
+
+/**
+ * Takes one completion off the completion ring.
+ *
+ * @param r    Pointer to the ring.
+ * @param tag  Receives the tag given when the entry was prepared.
+ * @param res  Receives bytes written or a negative errno.
+ * @return true if a completion was taken, false if none is ready.
+ */
+bool io_ring_complete(IoRing *r, uint64_t *tag, int *res) {
+    const unsigned head = atomic_load_explicit(r->cq_head, memory_order_relaxed);
+    if (head == atomic_load_explicit(r->cq_tail, memory_order_acquire)) return false;
+
+    const struct io_uring_cqe *cqe = &r->cqes[head & r->cq_mask];
+    *tag = cqe->user_data;
+    *res = cqe->res;
+    atomic_store_explicit(r->cq_head, head + 1, memory_order_release);
+    return true;
+}
+
+#else // no io_uring in this build, callers use plain writev()
+
+bool io_ring_init(IoRing *r, const unsigned entries) {
+    (void)entries;
+    r->fd = -1;
+    r->queued = 0;
+    r->error = 0;
+    return false;
+}
+
+void io_ring_destroy(IoRing *r) {
+    (void)r;
+}
+
+bool io_ring_sendmsg(IoRing *r, const int fd, const struct msghdr *msg, const uint64_t tag) {
+    (void)r; (void)fd; (void)msg; (void)tag;
+    return false;
+}
+
+int io_ring_submit(IoRing *r) {
+    (void)r;
+    return -1;
+}
+
+bool io_ring_complete(IoRing *r, uint64_t *tag, int *res) {
+    (void)r; (void)tag; (void)res;
+    return false;
+}
+
+#endif
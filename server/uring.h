@@ -0,0 +1,46 @@
+#ifndef SERPENT_URING_H
+#define SERPENT_URING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+// minimal io_uring over raw syscalls (no liburing needed), used to hand the
+// writes of many sockets to the kernel in a single io_uring_enter() call
+// fd is -1 when the kernel (or the build) has no io_uring support
+typedef struct {
+    int fd;
+    unsigned queued; // prepared entries not yet submitted
+    int error; // errno of a failed io_uring_enter(), the ring should not be used after that
+
+    _Atomic unsigned *sq_head;
+    _Atomic unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+
+    _Atomic unsigned *cq_head;
+    _Atomic unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void *sq_map; // mmapped rings, cq_map == sq_map on single mmap kernels
+    void *cq_map;
+    size_t sq_map_len;
+    size_t cq_map_len;
+    size_t sqes_len;
+} IoRing;
+
+bool io_ring_init(IoRing *r, unsigned entries);
+void io_ring_destroy(IoRing *r);
+
+bool io_ring_sendmsg(IoRing *r, int fd, const struct msghdr *msg, uint64_t tag);
+int io_ring_submit(IoRing *r);
+bool io_ring_complete(IoRing *r, uint64_t *tag, int *res);
+
+#endif //SERPENT_URING_H
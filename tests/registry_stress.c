@@ -0,0 +1,178 @@
+#define _POSIX_C_SOURCE 200112L
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "registry.h"
+
+// copy-on-write registry under concurrent accept, remove and broadcast: acceptor threads
+// register socketpair ends, remover threads drop random clients and check their socket gets
+// closed once no snapshot holds it anymore, reader threads iterate snapshots, send to every
+// client and send to handles that may already be stale
+// best run in an -fsanitize=address or -fsanitize=thread build as well
+
+#define ACCEPTORS 2
+#define REMOVERS 2
+#define READERS 4
+#define DEFAULT_SECONDS 2
+#define CLOSE_TIMEOUT_S 2 // a removed client's socket must be closed within this time
+
+typedef struct {
+    PlayerHandle handle;
+    int peer; // our end of the client's socketpair
+} Conn;
+
+static ClientRegistry registry;
+
+// connections currently registered, shared by acceptors and removers
+static pthread_mutex_t conns_lock = PTHREAD_MUTEX_INITIALIZER;
+static Conn conns[MAX_PLAYERS];
+static size_t conn_count;
+
+static _Atomic bool stop;
+static _Atomic size_t accepted;
+static _Atomic size_t removed;
+static _Atomic size_t snapshots;
+static _Atomic size_t failures;
+
+static void fail(const char *what) {
+    fprintf(stderr, "FAIL: %s\n", what);
+    atomic_fetch_add(&failures, 1);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void *acceptor_thread(void *arg) {
+    (void)arg;
+    while (!atomic_load(&stop)) {
+        pthread_mutex_lock(&conns_lock);
+        const bool room = conn_count < MAX_PLAYERS;
+        pthread_mutex_unlock(&conns_lock);
+        if (!room) {
+            sched_yield();
+            continue;
+        }
+
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+            fail("socketpair");
+            break;
+        }
+        fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL, 0) | O_NONBLOCK); // as accepted sockets are
+        const Client *c = register_client(&registry, sv[0]);
+        if (!c) {
+            // removers free slots only after they were published as free, retry later
+            close(sv[0]);
+            close(sv[1]);
+            sched_yield();
+            continue;
+        }
+        const PlayerHandle h = c->handle; // safe, c stays listed until someone removes it by handle
+
+        pthread_mutex_lock(&conns_lock);
+        conns[conn_count++] = (Conn){ .handle = h, .peer = sv[1] };
+        pthread_mutex_unlock(&conns_lock);
+        atomic_fetch_add(&accepted, 1);
+    }
+    return NULL;
+}
+
+// reads whatever was sent until the registry closes its end, false if it never does
+static bool wait_closed(const int peer) {
+    char buf[4096];
+    const double deadline = now_s() + CLOSE_TIMEOUT_S;
+    while (now_s() < deadline) {
+        const ssize_t n = recv(peer, buf, sizeof buf, MSG_DONTWAIT);
+        if (n == 0) return true;
+        if (n < 0 && errno == ECONNRESET) return true;
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+        if (n < 0) sched_yield();
+    }
+    return false;
+}
+
+static void *remover_thread(void *arg) {
+    unsigned seed = (unsigned)(uintptr_t)arg;
+    while (true) {
+        pthread_mutex_lock(&conns_lock);
+        if (conn_count == 0) {
+            pthread_mutex_unlock(&conns_lock);
+            if (atomic_load(&stop)) break;
+            sched_yield();
+            continue;
+        }
+        const size_t i = (size_t)rand_r(&seed) % conn_count;
+        const Conn conn = conns[i];
+        conns[i] = conns[--conn_count];
+        pthread_mutex_unlock(&conns_lock);
+
+        remove_client(&registry, conn.handle);
+        remove_client(&registry, conn.handle); // stale now, must be ignored
+        if (!wait_closed(conn.peer)) fail("removed client's socket was never closed");
+        close(conn.peer);
+        atomic_fetch_add(&removed, 1);
+    }
+    return NULL;
+}
+
+static void *reader_thread(void *arg) {
+    unsigned seed = (unsigned)(uintptr_t)arg;
+    size_t round = 0;
+    while (!atomic_load(&stop)) {
+        ClientList *l = registry_acquire(&registry);
+        if (l->count > MAX_PLAYERS) fail("snapshot count out of range");
+        for (size_t i = 0; i < l->count; ++i) {
+            Client *c = l->clients[i];
+            if (atomic_load(&c->refs) == 0) fail("listed client has no reference");
+            if (l->by_slot[c->handle.slot] != c) fail("snapshot slot index disagrees with list");
+            if (round % 64 == 0) client_send(c, (Message){ .type = MSG_GAME_OVER }); // broadcast
+        }
+        registry_release(l);
+        atomic_fetch_add(&snapshots, 1);
+
+        // a handle picked at random is often gone or reused by the time it is sent to
+        const PlayerHandle h = { .slot = (uint32_t)rand_r(&seed) % MAX_PLAYERS, .gen = (uint32_t)rand_r(&seed) % 4 + 1 };
+        registry_send(&registry, h, (Message){ .type = MSG_GAME_OVER });
+        round++;
+    }
+    return NULL;
+}
+
+// usage: test-registry-stress [seconds]
+int main(const int argc, char *argv[]) {
+    const int seconds = argc > 1 ? atoi(argv[1]) : DEFAULT_SECONDS;
+    pthread_t threads[ACCEPTORS + REMOVERS + READERS];
+    size_t n = 0;
+
+    signal(SIGPIPE, SIG_IGN); // as in the server, a closed peer is an error return, not a signal
+    registry_init(&registry);
+    for (size_t i = 0; i < ACCEPTORS; ++i) pthread_create(&threads[n++], NULL, acceptor_thread, NULL);
+    for (size_t i = 0; i < REMOVERS; ++i) pthread_create(&threads[n++], NULL, remover_thread, (void *)(uintptr_t)(i + 1));
+    for (size_t i = 0; i < READERS; ++i) pthread_create(&threads[n++], NULL, reader_thread, (void *)(uintptr_t)(i + 100));
+
+    const struct timespec run = { .tv_sec = seconds, .tv_nsec = 0 };
+    nanosleep(&run, NULL);
+    atomic_store(&stop, true);
+    for (size_t i = 0; i < n; ++i) pthread_join(threads[i], NULL); // removers empty the registry on the way out
+
+    ClientList *l = registry_acquire(&registry);
+    if (l->count != 0) fail("clients left after every one was removed");
+    registry_release(l);
+    registry_destroy(&registry);
+
+    printf("accepted %zu, removed %zu, snapshots read %zu, failures %zu\n",
+           atomic_load(&accepted), atomic_load(&removed), atomic_load(&snapshots), atomic_load(&failures));
+    if (atomic_load(&accepted) == 0 || atomic_load(&accepted) != atomic_load(&removed)) fail("accept/remove counts");
+    return atomic_load(&failures) == 0 ? 0 : 1;
+}